@@ -30,6 +30,7 @@ namespace D3D9on12
 
         bool SupportsCastingTypelessResources() { return m_bSupportsCastingTypelessResources; }
         bool RequiresYUY2BlitWorkaround() const;
+        UINT GetPostTransformVertexCacheSize() const;
 
     protected:
         virtual void LogAdapterCreated( LUID *pluid, HRESULT hr );
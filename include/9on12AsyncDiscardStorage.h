@@ -0,0 +1,122 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // CPU storage handed out for LOCK_DISCARD on textures through LockAsync. The app fills it on its own thread, and the
+    // Rename that follows in order on the device thread uploads it into the texture and returns it to the free list.
+    struct AsyncDiscardStorage
+    {
+        UINT m_subresourceIndex;
+        UINT m_rowPitch;
+        UINT m_slicePitch;
+        std::vector<BYTE> m_data;
+    };
+
+    // The async discard storage of a texture: what each subresource's open lock writes to, and what earlier renames
+    // freed for reuse. Locks and unlocks come from the app thread while renames run on the device thread, so both are
+    // guarded by one mutex. It's only held to swap pointers, never across an allocation or an upload, so an async lock
+    // doesn't wait on a rename.
+    template<size_t maxFreeStorage>
+    class AsyncDiscardStoragePool
+    {
+    public:
+        ~AsyncDiscardStoragePool()
+        {
+            // A texture destroyed while still async discard locked never hands its storage to a Rename
+            for (AsyncDiscardStorage *pStorage : m_openStorage)
+            {
+                delete pStorage;
+            }
+        }
+
+        void SetNumSubresources(UINT numSubresources) { m_openStorage.resize(numSubresources, nullptr); }
+
+        // Called for the first lock of a subresource. The returned storage is what the rename cookie refers to.
+        AsyncDiscardStorage* Open(UINT subresourceIndex, UINT rowPitch, UINT slicePitch, size_t size)
+        {
+            std::unique_ptr<AsyncDiscardStorage> pStorage;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                for (auto it = m_freeStorage.begin(); it != m_freeStorage.end(); ++it)
+                {
+                    if ((*it)->m_data.size() == size)
+                    {
+                        pStorage = std::move(*it);
+                        m_freeStorage.erase(it);
+                        break;
+                    }
+                }
+            }
+
+            if (!pStorage)
+            {
+                pStorage.reset(new AsyncDiscardStorage()); // throw( bad_alloc )
+                pStorage->m_data.resize(size); // throw( bad_alloc )
+            }
+            pStorage->m_subresourceIndex = subresourceIndex;
+            pStorage->m_rowPitch = rowPitch;
+            pStorage->m_slicePitch = slicePitch;
+
+            std::lock_guard<std::mutex> lock(m_lock);
+            Check9on12(m_openStorage[subresourceIndex] == nullptr);
+            m_openStorage[subresourceIndex] = pStorage.release();
+            return m_openStorage[subresourceIndex];
+        }
+
+        // Recursive locks reuse the storage of the first lock, null if the subresource has none
+        AsyncDiscardStorage* GetOpen(UINT subresourceIndex)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_openStorage[subresourceIndex];
+        }
+
+        // After the last async unlock the rename cookie owns the storage
+        void Close(UINT subresourceIndex)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_openStorage[subresourceIndex] = nullptr;
+        }
+
+        // Takes ownership of the storage behind a rename cookie. getStorageSize returns what Open is passed for a
+        // subresource of this texture, so a cookie from another resource is caught before its data is uploaded.
+        template<typename GetStorageSizeFn>
+        std::unique_ptr<AsyncDiscardStorage> TakeCookie(void *pCookie, GetStorageSizeFn&& getStorageSize)
+        {
+            std::unique_ptr<AsyncDiscardStorage> pStorage(static_cast<AsyncDiscardStorage*>(pCookie));
+
+            std::lock_guard<std::mutex> lock(m_lock);
+            Check9on12(pStorage->m_subresourceIndex < m_openStorage.size());
+            Check9on12(pStorage->m_data.size() == getStorageSize(pStorage->m_subresourceIndex));
+
+            // The cookie takes ownership, so a lock that's somehow still open mustn't free it again later
+            if (m_openStorage[pStorage->m_subresourceIndex] == pStorage.get())
+            {
+                m_openStorage[pStorage->m_subresourceIndex] = nullptr;
+            }
+            return pStorage;
+        }
+
+        // Once uploaded the storage can be reused by a later lock
+        void Recycle(std::unique_ptr<AsyncDiscardStorage> pStorage)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_freeStorage.size() < maxFreeStorage)
+            {
+                m_freeStorage.push_back(std::move(pStorage));
+            }
+        }
+
+        size_t GetNumFreeStorage()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_freeStorage.size();
+        }
+
+    private:
+        std::mutex m_lock;
+        std::vector<AsyncDiscardStorage*> m_openStorage;
+        std::vector<std::unique_ptr<AsyncDiscardStorage>> m_freeStorage;
+    };
+};
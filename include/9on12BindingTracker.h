@@ -0,0 +1,30 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // Tracks the slots of one binding class that a resource is bound to as a bit per slot,
+    // so binding, unbinding and hazard checks are constant time regardless of how many slots are used
+    template<UINT NumBindSlots>
+    class BindingTracker
+    {
+        static_assert(NumBindSlots <= 32, "Binding slots are tracked in a 32-bit mask");
+    public:
+        void Bind(UINT bindIndex) { Check9on12(bindIndex < NumBindSlots); m_boundMask |= BIT(bindIndex); }
+        void Unbind(UINT bindIndex) { Check9on12(bindIndex < NumBindSlots); m_boundMask &= ~BIT(bindIndex); }
+
+        bool IsBound() { return m_boundMask != 0; }
+        UINT GetBindingMask() { return m_boundMask; }
+        UINT GetBindingCount() { return static_cast<UINT>(std::bitset<NumBindSlots>(m_boundMask).count()); }
+        UINT GetFirstBindingIndex()
+        {
+            Check9on12(IsBound());
+            unsigned long index;
+            _BitScanForward(&index, m_boundMask);
+            return index;
+        }
+    private:
+        UINT m_boundMask = 0;
+    };
+};
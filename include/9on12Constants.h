@@ -68,6 +68,8 @@ namespace D3D9on12
 
             void Destroy() { m_binding.Destroy(); }
 
+            bool IsDirty() const { return m_dataDirty; }
+
             void SetData(const void* pData, UINT startReg, UINT num)
             {
                 UINT copySize = num * m_sizePerElement;
@@ -139,6 +141,7 @@ namespace D3D9on12
             }
 
             void UpdateAppVisibleAndBindToPipeline(Device& device, UINT maxFloats, UINT maxInts, UINT maxBools);
+            bool IsDirty() const { return m_floats.IsDirty() || m_integers.IsDirty() || m_booleans.IsDirty(); }
             void NullOutBindings(Device& device, ConstantBufferBinding& nullCB);
 
         private:
@@ -200,6 +203,7 @@ namespace D3D9on12
         HRESULT Init();
 
         void BindShaderConstants();
+        bool AreAppConstantsDirty() const { return m_vertexShaderData.IsDirty() || m_pixelShaderData.IsDirty(); }
 
         VertexShaderConstants& GetVertexShaderConstants() { return m_vertexShaderData; }
         PixelShaderConstants& GetPixelShaderConstants() { return m_pixelShaderData; }
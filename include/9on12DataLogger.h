@@ -47,14 +47,193 @@ namespace D3D9on12
         ShaderInfo m_WorstCaseShader;
     };
 
+    // Counters backing the driver statistics queries (VERTEXSTATS and RESOURCEMANAGER) and the device dependent
+    // counters exposed through CheckCounter
+    struct DeviceStatistics
+    {
+        // Order matches D3DDDIQUERYTYPE_COUNTER_DEVICE_DEPENDENT + n, see g_cDeviceCounterInfo
+        enum DeviceCounter
+        {
+            ShaderConversions,
+            PipelineStateCompilations,
+            UploadHeapBytes,
+            LockStallMicroseconds,
+            ReadbackWaits,
+            Flushes,
+            ShaderCacheHits,
+            PipelineStateCacheHits,
+            DrawResolveMicroseconds,
+            PresentMicroseconds,
+            DDICalls,
+            NumDeviceCounters
+        };
+
+        struct ResourceTypeStatistics
+        {
+            UINT64 m_liveCount;
+            UINT64 m_liveBytes;
+            UINT64 m_videoMemoryCount;
+            UINT64 m_videoMemoryBytes;
+
+            // Reset on every Present
+            UINT64 m_videoMemoryCreatesSincePresent;
+            UINT64 m_bytesUploadedSincePresent;
+        };
+
+        DeviceStatistics() { memset(this, 0, sizeof(*this)); }
+
+        UINT64 m_renderedTrianglesSincePresent;
+        ResourceTypeStatistics m_resources[D3DRTYPECOUNT];
+
+        // Only accumulated while a device dependent counter query is between Begin and End
+        UINT64 m_counters[NumDeviceCounters];
+    };
+
     struct DataLogger
     {
 
         void AddShaderData(D3D10_SB_TOKENIZED_PROGRAM_TYPE shaderType, UINT numInstructions, UINT numExtraInstructions)
         {
             m_shaderDataLogger.AddShaderData(shaderType, numInstructions, numExtraInstructions);
+            AddToCounter(DeviceStatistics::ShaderConversions, 1);
+        }
+
+        void AddDraw(D3DPRIMITIVETYPE primitiveType, UINT primitiveCount, UINT instanceCount)
+        {
+            if (primitiveType == D3DPT_TRIANGLELIST || primitiveType == D3DPT_TRIANGLESTRIP || primitiveType == D3DPT_TRIANGLEFAN)
+            {
+                m_statistics.m_renderedTrianglesSincePresent += UINT64(primitiveCount) * instanceCount;
+            }
+        }
+
+        void AddResource(D3DRESOURCETYPE type, UINT64 sizeInBytes, bool isSystemMemory)
+        {
+            DeviceStatistics::ResourceTypeStatistics& stats = GetResourceStatistics(type);
+            stats.m_liveCount++;
+            stats.m_liveBytes += sizeInBytes;
+            if (!isSystemMemory)
+            {
+                stats.m_videoMemoryCount++;
+                stats.m_videoMemoryBytes += sizeInBytes;
+                stats.m_videoMemoryCreatesSincePresent++;
+            }
+        }
+
+        void RemoveResource(D3DRESOURCETYPE type, UINT64 sizeInBytes, bool isSystemMemory)
+        {
+            DeviceStatistics::ResourceTypeStatistics& stats = GetResourceStatistics(type);
+            Check9on12(stats.m_liveCount > 0 && stats.m_liveBytes >= sizeInBytes);
+            stats.m_liveCount--;
+            stats.m_liveBytes -= sizeInBytes;
+            if (!isSystemMemory)
+            {
+                stats.m_videoMemoryCount--;
+                stats.m_videoMemoryBytes -= sizeInBytes;
+            }
+        }
+
+        void AddUploadedBytes(D3DRESOURCETYPE type, UINT64 sizeInBytes)
+        {
+            GetResourceStatistics(type).m_bytesUploadedSincePresent += sizeInBytes;
+        }
+
+        void OnPresent()
+        {
+            m_statistics.m_renderedTrianglesSincePresent = 0;
+            for (DeviceStatistics::ResourceTypeStatistics& stats : m_statistics.m_resources)
+            {
+                stats.m_videoMemoryCreatesSincePresent = 0;
+                stats.m_bytesUploadedSincePresent = 0;
+            }
+        }
+
+        // The hot paths only pay for a branch while no counter query is active. Counters are only added to on the device
+        // thread, LockAsync and UnlockAsync run on the app thread and must not count anything.
+        void BeginCounterQuery()
+        {
+            m_activeCounterQueries++;
+            m_processActiveCounterQueries++;
+        }
+
+        void EndCounterQuery()
+        {
+            Check9on12(m_activeCounterQueries > 0);
+            m_activeCounterQueries--;
+            m_processActiveCounterQueries--;
+        }
+
+        bool IsCountingEnabled() const { return m_activeCounterQueries > 0; }
+        void AddToCounter(DeviceStatistics::DeviceCounter counter, UINT64 value)
+        {
+            Check9on12(counter != DeviceStatistics::DDICalls);
+            if (IsCountingEnabled())
+            {
+                m_statistics.m_counters[counter] += value;
+            }
+        }
+
+        // DDI calls are counted by D3D9on12_DDI_ENTRYPOINT_START, which has no device and runs on whichever thread the
+        // runtime calls from, so they're counted for the whole process while any device has a counter query active
+        static void CountDDICall()
+        {
+            if (m_processActiveCounterQueries.load(std::memory_order_relaxed) > 0)
+            {
+                m_processDDICalls.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        DeviceStatistics GetStatistics() const
+        {
+            DeviceStatistics statistics = m_statistics;
+            statistics.m_counters[DeviceStatistics::DDICalls] = m_processDDICalls.load(std::memory_order_relaxed);
+            return statistics;
         }
 
         ShaderDataLogger m_shaderDataLogger;
+
+    private:
+        DeviceStatistics::ResourceTypeStatistics& GetResourceStatistics(D3DRESOURCETYPE type)
+        {
+            Check9on12(UINT(type) < D3DRTYPECOUNT);
+            return m_statistics.m_resources[UINT(type) < D3DRTYPECOUNT ? UINT(type) : 0];
+        }
+
+        DeviceStatistics m_statistics;
+        UINT m_activeCounterQueries = 0;
+
+        static inline std::atomic<UINT> m_processActiveCounterQueries { 0 };
+        static inline std::atomic<UINT64> m_processDDICalls { 0 };
+    };
+
+    // Adds the microseconds spent in a scope to a device counter while a counter query is active
+    class ScopedCounterTimer
+    {
+    public:
+        ScopedCounterTimer(DataLogger& logger, DeviceStatistics::DeviceCounter counter, bool enabled = true) :
+            m_logger(logger), m_counter(counter), m_startTicks(0)
+        {
+            if (enabled && m_logger.IsCountingEnabled())
+            {
+                LARGE_INTEGER now;
+                QueryPerformanceCounter(&now);
+                m_startTicks = now.QuadPart;
+            }
+        }
+
+        ~ScopedCounterTimer()
+        {
+            if (m_startTicks && m_logger.IsCountingEnabled())
+            {
+                LARGE_INTEGER now, frequency;
+                QueryPerformanceCounter(&now);
+                QueryPerformanceFrequency(&frequency);
+                m_logger.AddToCounter(m_counter, UINT64(now.QuadPart - m_startTicks) * 1000000 / UINT64(frequency.QuadPart));
+            }
+        }
+
+    private:
+        DataLogger& m_logger;
+        const DeviceStatistics::DeviceCounter m_counter;
+        LONGLONG m_startTicks;
     };
 };
\ No newline at end of file
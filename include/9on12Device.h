@@ -82,9 +82,19 @@ namespace D3D9on12
 
         HRESULT DrawTriangleFan(_In_ OffsetArg baseVertex, _In_ UINT primitiveCount);
         HRESULT DrawWireframeTriangleFanWithEdgeFlags(_In_ OffsetArg baseVertex, _In_ UINT primitiveCount, _In_ UINT edgeFlags);
-        HRESULT DrawTriangleFanIndexed(_In_ OffsetArg baseVertex, _In_ UINT vertexCount, _In_ OffsetArg baseIndex, _In_ UINT primitiveCount);
+        HRESULT DrawTriangleFanIndexed(_In_ OffsetArg baseVertex, _In_ UINT minVertexIndex, _In_ UINT vertexCount, _In_ OffsetArg baseIndex, _In_ UINT primitiveCount);
 
         FastUploadAllocator& GetSystemMemoryAllocator() { return m_systemMemoryAllocator; }
+        FastUploadAllocator& GetSystemMemoryIndexAllocator() { return m_systemMemoryIndexAllocator; }
+
+        // List topology UP draws are held back so that following draws with the same state, whose data was appended
+        // to the same upload batches, can be merged into them. State changes are caught by the dirty flags, anything
+        // that records to the command list outside of a draw (clears, blits, locks, queries, presents, ...) or
+        // releases an object the held back draw uses must call FlushPendingDraw first.
+        bool IsMergeableDraw(D3DPRIMITIVETYPE primitiveType);
+        bool CanAppendToPendingDraw(D3DPRIMITIVETYPE primitiveType, bool isIndexed);
+        void RecordMergeableDraw(bool appendToPendingDraw, D3DPRIMITIVETYPE primitiveType, bool isIndexed, UINT count, UINT start, INT baseVertex);
+        void FlushPendingDraw();
         DataLogger &GetDataLogger() { return m_dataLogger; }
         template<D3D12TranslationLayer::EShaderStage ShaderStage>
         void SetConstantBuffer(UINT shaderRegister, D3D12TranslationLayer::Resource *pResource, UINT offsetInBytes)
@@ -111,7 +121,17 @@ namespace D3D9on12
 
         D3D12_FEATURE_DATA_D3D12_OPTIONS19 m_Options19;
 
-        D3D12TranslationLayer::COptLockedContainer<std::unordered_map<Resource*, std::vector<LockRange>>> m_lockedResourceRanges;
+        D3D12TranslationLayer::COptLockedContainer<std::unordered_map<Resource*, LockedRangeSet>> m_lockedResourceRanges;
+        // Bytes currently held by Resource index buffer shadows, bounded by RegistryConstants::g_cIndexBufferShadowMemoryLimit.
+        // Resources can be destroyed from another thread than the one filling shadows, so this is updated atomically.
+        std::atomic<UINT64> m_indexBufferShadowMemoryUsage { 0 };
+
+        // Readback resources used to read GPU-only resources on the CPU. Once the CPU is done reading one it is handed back
+        // so repeated readbacks of the same footprint (e.g. every frame) reuse it instead of creating a new resource.
+        unique_comptr<D3D12TranslationLayer::Resource> AcquireStagingReadbackResource(const D3D12TranslationLayer::ResourceCreationArgs &args);
+        void RecycleStagingReadbackResource(unique_comptr<D3D12TranslationLayer::Resource> pStagingResource);
+        // Called on present, releases readback resources that weren't reused during the frame that just ended
+        void TrimStagingReadbackResources();
         void SetDrawingPreTransformedVerts(bool preTransformedVerts);
 
     protected:
@@ -130,6 +150,25 @@ namespace D3D9on12
             {}
         } ;
 
+        // Line list indices for wireframe triangle fans with edge flags, at most 256 * 260 indices (260KB). The indices are
+        // uploaded through the system memory allocator like any UP index buffer.
+        static const size_t cMaxCachedWireframeTriangleFanPatterns = 256;
+        static const UINT cMaxCachedWireframeTriangleFanPrimitiveCount = 128;
+        WireframeTriangleFanIndexCache<cMaxCachedWireframeTriangleFanPatterns, cMaxCachedWireframeTriangleFanPrimitiveCount> m_wireframeTriangleFanIndexCache;
+
+        // Least recently recycled at the front. Copies into a readback resource are ordered after the CPU reads
+        // of its previous contents by the translation layer's fence tracking, so no extra waiting is needed on reuse.
+        // The list is bounded by RegistryConstants::g_cStagingReadbackCacheSize bytes.
+        struct FreeStagingReadbackResource
+        {
+            unique_comptr<D3D12TranslationLayer::Resource> m_pResource;
+            UINT64 m_size;
+            UINT64 m_recycledFrame;
+        };
+        std::deque<FreeStagingReadbackResource> m_freeStagingReadbackResources;
+        UINT64 m_freeStagingReadbackBytes = 0;
+        UINT64 m_stagingReadbackFrame = 0;
+
         // Make sure this is the last thing that gets called by the destructor
         std::optional<D3D12TranslationLayer::ImmediateContext> m_pImmediateContext;
         std::optional<D3D12TranslationLayer::SharedResourceHelpers> m_pSharedResourceHelpers;
@@ -159,6 +198,10 @@ namespace D3D9on12
 
         FastUploadAllocator m_systemMemoryAllocator;
 
+        FastUploadAllocator m_systemMemoryIndexAllocator;
+
+        PendingDraw m_pendingDraw;
+
         TriangleFanIndexBufferCache m_triangleFanIndexBufferCache;
         DataLogger m_dataLogger;
 
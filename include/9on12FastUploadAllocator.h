@@ -28,6 +28,10 @@ namespace D3D9on12
         ~FastUploadAllocator() = default;
 
         SubBuffer Allocate(UINT size);
+
+        // Pads the allocation so that it starts a whole number of elements past baseOffset when that fits in the
+        // current resource, letting it be addressed through a binding made for an earlier allocation.
+        SubBuffer AllocateAppended(UINT size, UINT baseOffset, UINT elementSize);
         void Destroy();
         void ClearDeferredDestroyedResource();
 
@@ -39,6 +43,8 @@ namespace D3D9on12
         UINT m_size;
         const UINT m_alignmentRequired;
         UINT m_spaceUsed;
+        // Unaligned end of the most recent allocation, m_spaceUsed is this rounded up to the alignment
+        UINT m_lastAllocationEnd;
 
         unique_unbind_resourceptr m_pResource;
         void* m_pMappedAddress;
@@ -0,0 +1,140 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // CPU copy of an index buffer's data, created the first time the index buffer feeds an indexed triangle fan and
+    // kept current through Lock/Unlock and buffer copies so that later fan conversions don't need a GPU readback.
+    // Writes that can't be mirrored on the CPU invalidate it, and the next conversion reads back and refills it.
+    class IndexBufferShadow
+    {
+    public:
+        IndexBufferShadow() = default;
+        IndexBufferShadow(const IndexBufferShadow&) = delete;
+        IndexBufferShadow& operator=(const IndexBufferShadow&) = delete;
+
+        ~IndexBufferShadow()
+        {
+            if (m_pMemoryUsage)
+            {
+                *m_pMemoryUsage -= m_data.size();
+            }
+        }
+
+        bool IsValid() const { return m_isValid; }
+        const BYTE* GetData() const { return m_isValid ? m_data.data() : nullptr; }
+
+        void Invalidate()
+        {
+            m_isValid = false;
+            m_pLockedData = nullptr;
+        }
+
+        // memoryUsage is shared by every shadow of a device and bounded by memoryLimit, a shadow that doesn't fit
+        // stays invalid so the index buffer keeps reading back from the GPU. isLocked is set when the index buffer
+        // has a lock open, which wasn't mirrored when it was taken since the shadow wasn't valid yet, so whatever the
+        // app writes before unlocking would be missed: the shadow stays invalid until the next fill after the unlock.
+        void Fill(std::atomic<UINT64>& memoryUsage, UINT64 memoryLimit, _In_ const void* pData, UINT64 size, bool isLocked)
+        {
+            Check9on12(m_pMemoryUsage == nullptr || m_pMemoryUsage == &memoryUsage);
+            if (m_data.size() != size)
+            {
+                // Reserve the bytes before allocating so concurrent fills can't overshoot the budget together
+                const UINT64 previousSize = m_data.size();
+                UINT64 currentUsage = memoryUsage.load();
+                do
+                {
+                    if (currentUsage - previousSize + size > memoryLimit)
+                    {
+                        Invalidate();
+                        return;
+                    }
+                } while (!memoryUsage.compare_exchange_weak(currentUsage, currentUsage - previousSize + size));
+                m_pMemoryUsage = &memoryUsage;
+
+                try
+                {
+                    m_data.resize(static_cast<size_t>(size)); // throw( bad_alloc )
+                }
+                catch (...)
+                {
+                    memoryUsage -= size;
+                    memoryUsage += m_data.size();
+                    throw;
+                }
+            }
+
+            memcpy(m_data.data(), pData, m_data.size());
+            m_pLockedData = nullptr;
+            m_isValid = !isLocked;
+        }
+
+        // Async locks write to memory that only becomes current on a later rename, and recursive locks overwrite the
+        // first lock's box, so neither can be mirrored on unlock. The next fan conversion reads back instead.
+        void Lock(_In_ const void* pLockedData, bool isAsync, bool isRecursive)
+        {
+            if (!m_isValid)
+            {
+                return;
+            }
+
+            if (isAsync || isRecursive)
+            {
+                Invalidate();
+            }
+            else
+            {
+                m_pLockedData = static_cast<const BYTE*>(pLockedData);
+            }
+        }
+
+        // Mirrors what the app wrote into [writtenStart, writtenEnd) through the last lock, while it's still mapped.
+        // pLockedData points at writtenStart.
+        void Unlock(bool isLastUnlock, UINT writtenStart, UINT writtenEnd)
+        {
+            if (isLastUnlock && m_pLockedData)
+            {
+                Write(writtenStart, m_pLockedData, writtenEnd - writtenStart);
+                m_pLockedData = nullptr;
+            }
+        }
+
+        // pSourceData is null when the copy's source isn't visible to the CPU, in which case it can't be mirrored
+        void Copy(UINT destinationOffset, _In_opt_ const BYTE* pSourceData, UINT sourceSize, UINT sourceStart, UINT sourceEnd, bool isBufferCopy)
+        {
+            if (!m_isValid)
+            {
+                return;
+            }
+
+            sourceEnd = min(sourceEnd, sourceSize);
+            if (pSourceData && isBufferCopy && sourceStart < sourceEnd)
+            {
+                Write(destinationOffset, pSourceData + sourceStart, sourceEnd - sourceStart);
+            }
+            else
+            {
+                Invalidate();
+            }
+        }
+
+    private:
+        void Write(UINT offsetInBytes, _In_ const void* pData, UINT sizeInBytes)
+        {
+            const size_t shadowSize = m_data.size();
+            if (!m_isValid || offsetInBytes >= shadowSize)
+            {
+                return;
+            }
+
+            sizeInBytes = static_cast<UINT>(min<size_t>(sizeInBytes, shadowSize - offsetInBytes));
+            memmove(m_data.data() + offsetInBytes, pData, sizeInBytes);
+        }
+
+        std::vector<BYTE> m_data;
+        bool m_isValid = false;
+        const BYTE* m_pLockedData = nullptr;
+        std::atomic<UINT64>* m_pMemoryUsage = nullptr;
+    };
+};
@@ -6,6 +6,17 @@ namespace D3D9on12
 {
     class Device;
 
+    // Binding that consecutive range-exact uploads are appended behind, so back to back UP draws keep the same
+    // VB/IB binding and only differ in their start vertex/index
+    struct UploadBatch
+    {
+        D3D12TranslationLayer::Resource* m_pResource = nullptr;
+        UINT m_baseOffset = 0;
+        UINT m_elementSize = 0;
+        // Changes whenever the batch restarts at a new binding, zero is never used for a started batch
+        UINT m_id = 0;
+    };
+
     struct InputBuffer
     {
         void InitWithUploadData(Device& device, UINT strideInBytes, CONST VOID* pDataToUpload = nullptr);
@@ -19,8 +30,15 @@ namespace D3D9on12
         VOID* GetSystemMemoryBase() { return (byte*)m_pDeferredSystemMemoryData + m_bufferOffset; }
         VOID* GetTriangleFanMemory() { Check9on12(m_isTriangleFanIndexBuffer); return m_tempGPUBuffer.m_pMappedAddress; }
 
-        HRESULT Upload(Device& device, OffsetArg baseVertexIndex, UINT vertexCount);
+        // Uploads [windowOffsetInBytes, windowOffsetInBytes + windowSizeInBytes) of the system memory data. When rebaseToWindow
+        // is set only the window is allocated and the D3D12 offset points at its first byte, so the draw must be rebased.
+        // A non-zero indexBias is added to every uploaded index when the biased indices still fit the index format.
+        HRESULT Upload(Device& device, FastUploadAllocator& allocator, UINT windowOffsetInBytes, UINT windowSizeInBytes, bool rebaseToWindow, UploadBatch* pBatch = nullptr, INT indexBias = 0);
         void ResetUploadedData();
+        bool IsUploadRebased() { return m_isUploadRebased; }
+        bool IsUploadBiased() { return m_isUploadBiased; }
+        // Elements between the D3D12 binding offset and the start of the uploaded window
+        UINT GetUploadElementOffset() { return m_uploadElementOffset; }
 
         bool IsSystemMemory() { return m_isSystemMemory; }
         bool IsTriangleFan() { return m_isTriangleFanIndexBuffer; }
@@ -35,8 +53,11 @@ namespace D3D9on12
         const void* m_pDeferredSystemMemoryData = nullptr;
         bool m_isSystemMemory = false;
         bool m_isTriangleFanIndexBuffer = false;
+        bool m_isUploadRebased = false;
+        bool m_isUploadBiased = false;
 
         FastUploadAllocator::SubBuffer m_tempGPUBuffer = {};
+        UINT m_uploadElementOffset = 0;
 
         UINT m_bufferStride = 0;
         UINT m_bufferOffset = 0;
@@ -61,9 +82,19 @@ namespace D3D9on12
         HRESULT SetIndexBuffer(Device &device, Resource *pResource, UINT stride);
         HRESULT SetIndexBufferUM(Device &device, UINT indexBufferStride, _In_ const void *pIndices);
 
-        HRESULT UploadDeferredInputBufferData(Device& device, OffsetArg baseVertexIndex, UINT vertexCount, OffsetArg baseIndexLocation, UINT indexCount);
+        HRESULT UploadDeferredInputBufferData(Device& device, OffsetArg baseVertexIndex, UINT minVertexIndex, UINT vertexCount, UINT instanceCount, OffsetArg baseIndexLocation, UINT indexCount);
         void ResetUploadBufferData();
 
+        // Vertices/indices that must be subtracted from the draw's start/base vertex and start index when the
+        // system memory streams and index buffer for the current draw were uploaded range-exact
+        INT GetUploadedVertexRebase() { return m_uploadedVertexRebase; }
+        INT GetUploadedIndexRebase() { return m_uploadedIndexRebase; }
+
+        // Batches the current draw's vertex and index data were appended to, or zero if they weren't. Draws with the
+        // same ids read through identical VB/IB bindings.
+        UINT GetVertexUploadBatchId() { return m_vertexUploadBatchId; }
+        UINT GetIndexUploadBatchId() { return m_indexUploadBatchId; }
+
         void SetPrimitiveTopology(Device &device, D3DPRIMITIVETYPE primitiveType);
 
         HRESULT ResolveDeferredState(Device &device, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& psoDesc, OffsetArg BaseVertexStart, OffsetArg BaseIndexStart);
@@ -88,6 +119,12 @@ namespace D3D9on12
 
         InputBuffer m_inputStreams[MAX_VERTEX_STREAMS];
         UINT m_numBoundVBs;
+        INT m_uploadedVertexRebase;
+        INT m_uploadedIndexRebase;
+        UploadBatch m_vertexUploadBatch;
+        UploadBatch m_indexUploadBatch;
+        UINT m_vertexUploadBatchId;
+        UINT m_indexUploadBatchId;
 
 
         std::stack<InputBuffer> m_IndexBufferStack;
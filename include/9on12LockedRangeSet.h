@@ -0,0 +1,59 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // Byte ranges of a buffer locked since the last frame, kept sorted by start and coalesced with their neighbors
+    // so overlap queries and inserts are logarithmic in the number of disjoint ranges
+    class LockedRangeSet
+    {
+    public:
+        bool Overlaps(UINT start, UINT end) const
+        {
+            if (start >= end)
+            {
+                return false;
+            }
+
+            // Only the last range starting at or before 'start' and the first range after it can intersect
+            auto next = m_ranges.upper_bound(start);
+            if (next != m_ranges.end() && next->first < end)
+            {
+                return true;
+            }
+            return next != m_ranges.begin() && std::prev(next)->second > start;
+        }
+
+        // Callers only insert ranges that don't overlap the set (or into an empty set), so only touching neighbors need merging
+        void Insert(UINT start, UINT end)
+        {
+            if (start >= end)
+            {
+                return;
+            }
+
+            auto next = m_ranges.lower_bound(start);
+            if (next != m_ranges.end() && next->first == end)
+            {
+                end = next->second;
+                next = m_ranges.erase(next);
+            }
+
+            if (next != m_ranges.begin() && std::prev(next)->second == start)
+            {
+                std::prev(next)->second = end;
+            }
+            else
+            {
+                m_ranges.emplace_hint(next, start, end);
+            }
+        }
+
+        void Clear() { m_ranges.clear(); }
+
+    private:
+        // Start offset -> end offset (exclusive)
+        std::map<UINT, UINT> m_ranges;
+    };
+};
@@ -0,0 +1,74 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // Copies into a system memory resource whose GPU side has been recorded but whose CPU side is deferred until the
+    // data is read, kept in the order they were recorded so overlapping copies land in the right order. Copy needs
+    // m_destinationSubresourceIndex, m_numSubresources and m_dimensionsCoverEntireResource.
+    //
+    // Only the device thread changes the queue. IsEmpty can be called from the app thread, since async locks check it.
+    template<typename Copy, size_t maxPendingCopies>
+    class PendingCopyQueue
+    {
+    public:
+        bool IsEmpty() const { return m_numPendingCopies.load() == 0; }
+        size_t Size() const { return m_copies.size(); }
+
+        // A pending copy whose destination subresources are all fully overwritten by newCopy would only have its
+        // result thrown away, so it's handed to discard without ever being completed
+        template<typename DiscardFn>
+        void DiscardSuperseded(const Copy& newCopy, DiscardFn&& discard)
+        {
+            if (!newCopy.m_dimensionsCoverEntireResource)
+            {
+                return;
+            }
+
+            const UINT newCopyEnd = newCopy.m_destinationSubresourceIndex + newCopy.m_numSubresources;
+            for (auto it = m_copies.begin(); it != m_copies.end();)
+            {
+                if (it->m_destinationSubresourceIndex >= newCopy.m_destinationSubresourceIndex &&
+                    it->m_destinationSubresourceIndex + it->m_numSubresources <= newCopyEnd)
+                {
+                    discard(*it);
+                    it = m_copies.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            m_numPendingCopies = m_copies.size();
+        }
+
+        // Every pending copy holds a staging resource, so past the cap the oldest one is completed now to free it
+        template<typename CompleteFn>
+        void Push(Copy&& copy, CompleteFn&& complete)
+        {
+            if (m_copies.size() >= maxPendingCopies)
+            {
+                complete(m_copies.front());
+                m_copies.erase(m_copies.begin());
+            }
+            m_copies.push_back(std::move(copy));
+            m_numPendingCopies = m_copies.size();
+        }
+
+        template<typename CompleteFn>
+        void Resolve(CompleteFn&& complete)
+        {
+            for (Copy& copy : m_copies)
+            {
+                complete(copy);
+            }
+            m_copies.clear();
+            m_numPendingCopies = 0;
+        }
+
+    private:
+        std::vector<Copy> m_copies;
+        std::atomic<size_t> m_numPendingCopies { 0 };
+    };
+};
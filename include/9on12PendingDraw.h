@@ -0,0 +1,91 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // A list topology UP draw held back so that following draws with the same state, whose data was appended to the
+    // same upload batches, can be merged into it. A batch id of 0 means the data wasn't uploaded into a batch.
+    //
+    // The context only needs the translation layer's DrawInstanced/DrawIndexedInstanced, which lets the merging be
+    // replayed against a recording context on the host.
+    class PendingDraw
+    {
+    public:
+        // Concatenated lists draw the same primitives as the separate draws did, strips and fans don't
+        static bool IsMergeablePrimitiveType(D3DPRIMITIVETYPE primitiveType)
+        {
+            return primitiveType == D3DPT_POINTLIST || primitiveType == D3DPT_LINELIST || primitiveType == D3DPT_TRIANGLELIST;
+        }
+
+        bool IsPending() const { return m_isPending; }
+
+        // Matching batch ids mean the VB/IB bindings made for the pending draw still address this draw's data, the
+        // caller is responsible for checking that none of the other state changed
+        bool CanAppend(D3DPRIMITIVETYPE primitiveType, bool isIndexed, UINT vertexUploadBatchId, UINT indexUploadBatchId) const
+        {
+            return m_isPending &&
+                m_primitiveType == primitiveType &&
+                m_isIndexed == isIndexed &&
+                vertexUploadBatchId != 0 &&
+                vertexUploadBatchId == m_vertexUploadBatchId &&
+                (!isIndexed || indexUploadBatchId == m_indexUploadBatchId);
+        }
+
+        template<typename Context>
+        void Record(Context& context, bool append, D3DPRIMITIVETYPE primitiveType, bool isIndexed, UINT count, UINT start, INT baseVertex, UINT vertexUploadBatchId, UINT indexUploadBatchId)
+        {
+            if (append &&
+                m_start + m_count == start &&
+                m_baseVertex == baseVertex)
+            {
+                m_count += count;
+                return;
+            }
+
+            Flush(context);
+
+            m_isPending = true;
+            m_isIndexed = isIndexed;
+            m_primitiveType = primitiveType;
+            m_count = count;
+            m_start = start;
+            m_baseVertex = baseVertex;
+            m_vertexUploadBatchId = vertexUploadBatchId;
+            m_indexUploadBatchId = indexUploadBatchId;
+
+            // Nothing can be appended to a draw whose data wasn't uploaded into the batches
+            if (vertexUploadBatchId == 0 || (isIndexed && indexUploadBatchId == 0))
+            {
+                Flush(context);
+            }
+        }
+
+        template<typename Context>
+        void Flush(Context& context)
+        {
+            if (m_isPending)
+            {
+                m_isPending = false;
+                if (m_isIndexed)
+                {
+                    context.DrawIndexedInstanced(m_count, 1, m_start, m_baseVertex, 0);
+                }
+                else
+                {
+                    context.DrawInstanced(m_count, 1, m_start, 0);
+                }
+            }
+        }
+
+    private:
+        bool m_isPending = false;
+        bool m_isIndexed = false;
+        D3DPRIMITIVETYPE m_primitiveType = D3DPT_POINTLIST;
+        UINT m_count = 0;
+        UINT m_start = 0;
+        INT m_baseVertex = 0;
+        UINT m_vertexUploadBatchId = 0;
+        UINT m_indexUploadBatchId = 0;
+    };
+};
@@ -25,6 +25,7 @@ namespace D3D9on12
 
         void MarkPipelineStateNeeded() { m_bNeedsPipelineState = true; }
         void MarkInputLayoutAsDirty() { m_dirtyFlags.InputLayout = true; }
+        bool AreOnlyInputBuffersDirty() { return m_dirtyFlags.AreOnlyInputBuffersDirty(); }
 
         D3D12_GRAPHICS_PIPELINE_STATE_DESC& CurrentPSODesc() { return m_PSODesc; }
 
@@ -59,6 +60,11 @@ namespace D3D9on12
             FLOAT m_fRenderStates[D3DHAL_MAX_RSTATES];
         };
 
+        // States that have been set at least once. Until then the stored value doesn't reflect what the stages hold,
+        // so a set can't be treated as redundant.
+        std::bitset<MAX_D3DTSS> m_textureStageStatesSet[MAX_SAMPLERS_STAGES];
+        std::bitset<D3DHAL_MAX_RSTATES> m_renderStatesSet;
+
         D3D12_GRAPHICS_PIPELINE_STATE_DESC m_PSODesc;
         
         BOOL m_intzRestoreZWrite;
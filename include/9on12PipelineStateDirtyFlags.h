@@ -0,0 +1,114 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    struct PipelineStateDirtyFlags
+    {
+        union
+        {
+            UINT64 MiscFlags;
+            struct
+            {
+                UINT VSExtension : 1;
+                UINT PSExtension : 1;
+                UINT PSExtension2 : 1;
+                UINT PSExtension3 : 1;
+                UINT VertexBuffers : 1;
+                UINT IndexBuffer : 1;
+                UINT Samplers : MAX_SAMPLERS_STAGES;
+                UINT Textures : MAX_SAMPLERS_STAGES;
+            };
+        };
+
+        union
+        {
+            UINT64 PSOFlags;
+            struct
+            {
+                UINT RenderTargets : MAX_RENDER_TARGETS;
+                UINT DepthStencil : 1;
+                UINT Viewport : 1;
+                UINT Topology : 1;
+                UINT InputLayout : 1;
+                UINT RasterizerState : 1;
+                UINT DepthStencilState : 1;
+                UINT BlendState : 1;
+                UINT PointSize : 1;
+                UINT IndexedStream : 1;
+                UINT VertexShader : 1;
+                UINT PixelShader : 1;
+                UINT GeometryShader : 1;
+            };
+        };
+
+
+        PipelineStateDirtyFlags()
+        {
+            Clear();
+            C_ASSERT(sizeof(PipelineStateDirtyFlags) == 2 * sizeof(UINT64));
+        }
+
+        void Clear()
+        {
+            memset(&MiscFlags, 0, sizeof(MiscFlags));
+            memset(&PSOFlags, 0, sizeof(MiscFlags));
+        }
+
+        bool IsPSOChangeRequired()
+        {
+            return PSOFlags != 0;
+        }
+
+        bool IsDirty()
+        {
+            return (MiscFlags | PSOFlags) != 0;
+        }
+
+        // Back to back draws that only differ in their arguments have nothing to resolve except the app's shader
+        // constants, which track their own changes. Byte offset draws bake the offset into the bound VB/IB, so they
+        // always go through the full resolve.
+        bool CanSkipResolve(bool isVertexStartInBytes, bool isIndexStartInBytes)
+        {
+            return !IsDirty() && !isVertexStartInBytes && !isIndexStartInBytes;
+        }
+
+        // Raster state changes that affect the VS or GS mark the vertex, pixel or geometry shader dirty, so with none of
+        // these set the current shaders and GS selection are still valid
+        bool AreVertexStageInputsDirty()
+        {
+            return Viewport || PointSize || VSExtension || VertexShader || InputLayout || PixelShader || GeometryShader;
+        }
+
+        // What's left dirty for the next draw once a draw's state is resolved
+        void ClearAfterResolve(bool isVertexStartInBytes, bool isIndexStartInBytes, UINT textureDirtyMaskToKeep)
+        {
+            Clear();
+
+            // If this draw call was made with byte offsetting, we bake this offset in to the bounded VB/IB.
+            // We must clean this up for draws that won't expect this additional offset in the VB/IB
+            if (isVertexStartInBytes)
+            {
+                VertexBuffers |= BIT(0);
+            }
+
+            if (isIndexStartInBytes)
+            {
+                IndexBuffer = true;
+            }
+
+            Textures |= textureDirtyMaskToKeep;
+        }
+
+        // UP draws rebind their vertex and index data on every call, so only these may change between draws that
+        // are merged together
+        bool AreOnlyInputBuffersDirty()
+        {
+            PipelineStateDirtyFlags inputBuffers;
+            inputBuffers.VertexBuffers = 1;
+            inputBuffers.IndexBuffer = 1;
+            return (MiscFlags & ~inputBuffers.MiscFlags) == 0 && PSOFlags == 0;
+        }
+    };
+};
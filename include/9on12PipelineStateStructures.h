@@ -4,63 +4,6 @@
 
 namespace D3D9on12
 {
-    struct PipelineStateDirtyFlags
-    {
-        union
-        {
-            UINT64 MiscFlags;
-            struct
-            {
-                UINT VSExtension : 1;
-                UINT PSExtension : 1;
-                UINT PSExtension2 : 1;
-                UINT PSExtension3 : 1;
-                UINT VertexBuffers : 1;
-                UINT IndexBuffer : 1;
-                UINT Samplers : MAX_SAMPLERS_STAGES;
-                UINT Textures : MAX_SAMPLERS_STAGES;
-            };
-        };
-
-        union
-        {
-            UINT64 PSOFlags;
-            struct
-            {
-                UINT RenderTargets : MAX_RENDER_TARGETS;
-                UINT DepthStencil : 1;
-                UINT Viewport : 1;
-                UINT Topology : 1;
-                UINT InputLayout : 1;
-                UINT RasterizerState : 1;
-                UINT DepthStencilState : 1;
-                UINT BlendState : 1;
-                UINT PointSize : 1;
-                UINT IndexedStream : 1;
-                UINT VertexShader : 1;
-                UINT PixelShader : 1;
-            };
-        };
-
-
-        PipelineStateDirtyFlags()
-        {
-            Clear();
-            C_ASSERT(sizeof(PipelineStateDirtyFlags) == 2 * sizeof(UINT64));
-        }
-
-        void Clear()
-        {
-            memset(&MiscFlags, 0, sizeof(MiscFlags));
-            memset(&PSOFlags, 0, sizeof(MiscFlags));
-        }
-
-        bool IsPSOChangeRequired()
-        {
-            return PSOFlags != 0;
-        }
-    };
-
     class Resource;
 
     struct BoundRenderTarget
@@ -230,55 +173,6 @@ namespace D3D9on12
         }
     };
 
-    struct SamplerStateID
-    {
-        union
-        {
-            UINT Flags;
-            struct
-            {
-                UINT MagFilter : 4;
-                UINT MinFilter : 4;
-                UINT MipFilter : 4;
-                UINT AddressU : 3;
-                UINT AddressV : 3;
-                UINT AddressW : 3;
-                UINT MaxAnisotropy : 8;
-                UINT UseHardwareShadowMapping : 1;
-                UINT SwapRBBorderColors : 1;
-            };
-        };
-        UINT  BorderColor;
-        UINT  MaxMipLevel;
-        FLOAT MipLODBias;
-
-        SamplerStateID() : Flags(0),
-            BorderColor(0),
-            MaxMipLevel(0),
-            MipLODBias(0.0f)
-        {
-            C_ASSERT(sizeof(SamplerStateID) == sizeof(Flags) +
-                sizeof(BorderColor) +
-                sizeof(MaxMipLevel) +
-                sizeof(MipLODBias));
-        }
-        bool operator==(const SamplerStateID& rhs) const
-        {
-            return (this->Flags == rhs.Flags)
-                && (this->BorderColor == rhs.BorderColor)
-                && (this->MaxMipLevel == rhs.MaxMipLevel)
-                && (this->MipLODBias == rhs.MipLODBias);
-        }
-        bool operator!=(const SamplerStateID& rhs) const
-        {
-            return !(*this == rhs);
-        }
-        operator UINT() const
-        {
-            return this->Flags;
-        }
-    };
-
     static D3D12_RASTERIZER_DESC ConvertRasterizerState(RasterizerStateID rasterizerID, bool bDepthEnabledAndBound, DXGI_FORMAT dsvFormat)
     {
         D3D12_RASTERIZER_DESC rasterizerDesc = {};
@@ -815,6 +709,7 @@ namespace D3D9on12
 
         void MarkGSDirty()
         {
+            m_dirtyFlags.GeometryShader = true;
         }
 
         template<typename T>
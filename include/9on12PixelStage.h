@@ -46,22 +46,42 @@ namespace D3D9on12
         D3D12PixelShader* GetCurrentD3D12PixelShader() { return m_pCurrentD3D12PixelShader; }
 
         PixelShader* GetCurrentD3D9PixelShader() { return m_pCurrentPS; }
-        void MarkSRVIndicesDirty(const std::vector<UINT> &indices);
+        void MarkSRVIndicesDirty(UINT indexMask);
+
+        // Must be called when a resource's views are destroyed, the context has already dropped its bindings of them
+        void ClearBoundShaderResourceViews(Resource* pResource);
 
     private: // Types
+        // LRU cache bounded by RegistryConstants::g_cMaxCachedSamplers. Draws copy the sampler descriptors into the
+        // translation layer's fence-recycled shader visible heap, so only samplers still bound to a stage are
+        // referenced after creation and those are never evicted.
         struct SamplerCache
         {
-            D3D12TranslationLayer::Sampler* GetSampler( Device& device, SamplerStateID& id );
+            D3D12TranslationLayer::Sampler* GetSampler( Device& device, SamplerStateID& id, UINT stage );
         private:
+            void EvictLeastRecentlyUsed();
+
             //Required for stl map
             struct Hasher {
                 size_t operator()( SamplerStateID const& other ) const { return size_t( HashData( &other, sizeof( other ) ).m_data ); }
             };
 
+            // Every stage can pin a sampler, so keep room for one more
+            static const size_t cMinCachedSamplers = MAX_SAMPLERS_STAGES + 1;
+
+            // Least recently used at the front
+            typedef std::list<SamplerStateID> LRUListType;
+            struct CacheEntry
+            {
+                std::unique_ptr<D3D12TranslationLayer::Sampler> m_pSampler;
+                LRUListType::iterator m_lruPosition;
+            };
 
-            typedef std::unordered_map < SamplerStateID, std::unique_ptr<D3D12TranslationLayer::Sampler>, Hasher > MapType;
+            typedef std::unordered_map < SamplerStateID, CacheEntry, Hasher > MapType;
 
             MapType m_map;
+            LRUListType m_lru;
+            D3D12TranslationLayer::Sampler* m_pBoundSamplers[MAX_SAMPLERS_STAGES] = {};
         };
 
         struct ComputedRasterStates {
@@ -69,9 +89,23 @@ namespace D3D9on12
             UINT m_alphaFunc;
         };
 
+        // Outcome of the SRV vs RTV/DSV hazard check for the resource in a texture slot. It only depends on what's bound
+        // as output, ZWriteEnable and the resource declarations of the current shaders, all of which bump
+        // m_outputBindingGeneration when they change, so the check is skipped while the generation still matches.
+        struct SRVHazardState
+        {
+            Resource* m_pResource = nullptr;
+            UINT64 m_generation = 0;
+            bool m_hideSRV = false;
+            bool m_boundAsRenderTarget = false;
+            bool m_sampleBackingCopy = false;
+        };
+
     private: // Methods
         void ResolveRenderTargets(Device &device, D3D12_GRAPHICS_PIPELINE_STATE_DESC& psoDesc, bool bDSVBound);
         Resource* FindFirstValidBoundWritableResource();
+        void BindShaderResourceRanges(Device& device, D3D12TranslationLayer::SRV* const (&pSRVs)[MAX_SAMPLERS_STAGES], UINT changedMask);
+        void CheckSRVHazard(Device& device, UINT textureIndex, Resource* pResource, SRVHazardState& hazard);
         inline void SetAlphaToCoverageEnabled( const bool enabled );
 
     private: // Members
@@ -85,6 +119,15 @@ namespace D3D9on12
         SamplerStateID              m_samplerStateIDs[MAX_SAMPLERS_STAGES];
 
         Resource*                   m_shaderResources[MAX_SAMPLERS_STAGES];
+        // What the context currently has bound for each texture index, and the resource owning that view
+        D3D12TranslationLayer::SRV* m_pBoundSRVs[MAX_SAMPLERS_STAGES];
+        Resource*                   m_pBoundSRVResources[MAX_SAMPLERS_STAGES];
+        UINT64                      m_textureResolveGeneration = 0;
+        SRVHazardState              m_srvHazardStates[MAX_SAMPLERS_STAGES];
+        // Starts at 1 so default constructed SRVHazardStates are never current
+        UINT64                      m_outputBindingGeneration = 1;
+        const void*                 m_pHazardCheckedPSDecls = nullptr;
+        const void*                 m_pHazardCheckedVSDecls = nullptr;
         bool                        m_SRGBTexture[MAX_SAMPLERS_STAGES];
         bool                        m_SRGBWriteEnabled;
         bool                        m_hideDepthStencil;
@@ -12,12 +12,15 @@ namespace D3D9on12
         D3DQUERYTYPE_TIMESTAMP,
         D3DQUERYTYPE_TIMESTAMPDISJOINT,
         D3DQUERYTYPE_TIMESTAMPFREQ,
+        D3DQUERYTYPE_RESOURCEMANAGER,
+        D3DQUERYTYPE_VERTEXSTATS,
     };
 
     class Query
     {
     public:
         Query(D3DDDIQUERYTYPE queryType);
+        ~Query();
 
         static FORCEINLINE HANDLE GetHandleFromQuery(Query* pQuery){ return static_cast<HANDLE>(pQuery); }
         static FORCEINLINE Query* GetQueryFromHandle(HANDLE hQuery){ return static_cast<Query*>(hQuery); }
@@ -27,10 +30,26 @@ namespace D3D9on12
         HRESULT GetData(Device& device, VOID* pData);
 
     private:
+        // Polls the translation layer query without flushing and caches the result once it's available
+        bool PollUnderlyingQuery(_Out_writes_bytes_(dataSize) void* pData, UINT dataSize);
+
         D3DDDIQUERYTYPE m_type;
 
+        // Each occlusion query resolves into its own readback heap owned by the translation layer's Query. Batching the
+        // resolves of a command list into one shared readback buffer isn't done, it would be a translation layer change.
         std::unique_ptr<D3D12TranslationLayer::Async> m_pUnderlyingQuery;
 
+        // Sized for the largest query payload
+        QueryResultCache<sizeof(D3D12TranslationLayer::QUERY_DATA_TIMESTAMP_DISJOINT)> m_resultCache;
+
+        // Statistics and device dependent counter queries are answered from the device's DataLogger counters captured at Begin/End
+        HRESULT IssueStatistics(Device& device, D3DDDI_ISSUEQUERYFLAGS flags);
+        void FillStatisticsData(VOID* pData);
+
+        DeviceStatistics m_beginStatistics;
+        DeviceStatistics m_endStatistics;
+        DataLogger* m_pActiveLogger; // Set between Begin and End of a device dependent counter query
+
         static const UINT64 m_cUnitializedFenceValue = _UI64_MAX;
         UINT64 m_eventFenceValue;
     };
@@ -0,0 +1,39 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // The result of a query, kept once the underlying query has it so that repeated polls of a finished query don't map
+    // its readback again. Every Issue resets it, so a result from before the last Begin/End is never returned.
+    template<size_t maxResultSize>
+    class QueryResultCache
+    {
+    public:
+        void Reset() { m_isResultCached = false; }
+        bool IsResultCached() const { return m_isResultCached; }
+
+        // poll(pResult, dataSize) asks the underlying query for its result, returning false while it isn't available
+        template<typename PollFn>
+        bool GetResult(_Out_writes_bytes_(dataSize) void* pData, UINT dataSize, PollFn&& poll)
+        {
+            Check9on12(dataSize <= maxResultSize);
+
+            if (!m_isResultCached)
+            {
+                if (!poll(m_result, dataSize))
+                {
+                    return false;
+                }
+                m_isResultCached = true;
+            }
+
+            memcpy(pData, m_result, dataSize);
+            return true;
+        }
+
+    private:
+        BYTE m_result[maxResultSize];
+        bool m_isResultCached = false;
+    };
+};
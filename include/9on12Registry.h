@@ -30,6 +30,12 @@ namespace D3D9on12
         static const LPCSTR g_cMaxSRVHeapSize = "MaxSRVHeapSize";
         static const LPCSTR g_cBufferPoolTrimThreshold = "BufferPoolTrimThreshold"; // Must be in the range 5-100 to be used by the translation layer. If there is a compat shim, will take the lesser of the two values
         static const LPCSTR g_cLockDiscardOptimization = "LockDiscardOptimization";
+        static const LPCSTR g_cIndexBufferShadowMemoryLimit = "IndexBufferShadowMemoryLimit"; // In bytes, 0 disables CPU shadows of triangle fan index buffers
+        static const LPCSTR g_cMaxCachedSamplers = "MaxCachedSamplers"; // Samplers kept per device before the least recently used are destroyed
+        static const LPCSTR g_cVertexCacheSize = "VertexCacheSize"; // Post-transform vertex cache size reported by D3DQUERYTYPE_VCACHE, 0 picks a size based on the adapter vendor
+        static const LPCSTR g_cMergeUPDraws = "MergeUPDraws"; // Appends back to back list topology UP draws with identical state into a single draw
+        static const LPCSTR g_cStagingReadbackCacheSize = "StagingReadbackCacheSize"; // In bytes, readback resources kept for reuse once the CPU is done with them, 0 disables reuse
+        static const LPCSTR g_cParallelSubresourceCopyThreshold = "ParallelSubresourceCopyThreshold"; // In bytes, CPU subresource copies at least this large are split across threads, 0 disables the split
     };
 
     static DWORD CheckRegistryKeyDWORD(LPCSTR key, DWORD defaultValue = 0)
@@ -106,5 +112,11 @@ namespace D3D9on12
         static const DWORD g_cMaxSRVHeapSize = CheckRegistryKeyDWORD(RegistryKeys::g_cMaxSRVHeapSize, MAXDWORD);
         static const DWORD g_cBufferPoolTrimThreshold = CheckRegistryKeyDWORD(RegistryKeys::g_cBufferPoolTrimThreshold, MAXDWORD);
         static const bool g_cLockDiscardOptimization = CheckRegistryKeyDWORD(RegistryKeys::g_cLockDiscardOptimization, 1);
+        static const DWORD g_cIndexBufferShadowMemoryLimit = CheckRegistryKeyDWORD(RegistryKeys::g_cIndexBufferShadowMemoryLimit, 64 * 1024 * 1024);
+        static const DWORD g_cMaxCachedSamplers = CheckRegistryKeyDWORD(RegistryKeys::g_cMaxCachedSamplers, 1024);
+        static const DWORD g_cVertexCacheSize = CheckRegistryKeyDWORD(RegistryKeys::g_cVertexCacheSize, 0);
+        static const bool g_cMergeUPDraws = CheckRegistryKeyDWORD(RegistryKeys::g_cMergeUPDraws, 1);
+        static const DWORD g_cStagingReadbackCacheSize = CheckRegistryKeyDWORD(RegistryKeys::g_cStagingReadbackCacheSize, 32 * 1024 * 1024);
+        static const DWORD g_cParallelSubresourceCopyThreshold = CheckRegistryKeyDWORD(RegistryKeys::g_cParallelSubresourceCopyThreshold, 8 * 1024 * 1024);
     };
 };
\ No newline at end of file
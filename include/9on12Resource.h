@@ -151,6 +151,11 @@ namespace D3D9on12
         // * Binding System Memory as an SRV
         // * A resource that's the source of a DX12 internal blt present.
         virtual Resource *GetBackingPlainResource(bool bDoNotCreateAsTypelessResource = false);
+
+        // Same as GetBackingPlainResource, but the contents are only copied again when copyGeneration differs from the
+        // last call. Used for render targets that are sampled while bound, which are read from several texture slots
+        // in the same draw but can only change between draws.
+        Resource *GetBackingPlainResourceForGeneration(UINT64 copyGeneration);
         
         // Returns a resource that has the current contents of this resource
         // copied into a readback heap. Generally expected to be a short-lived
@@ -191,6 +196,12 @@ namespace D3D9on12
         static void CopyToSystemMemoryResource(Device& device, ResourceCopyArgs& args);
         static void CopyMatchingMipLevels(Device& device, ResourceCopyArgs& args);
 
+        // Finishes copies into this system memory resource whose CPU writes were deferred. Must be called before the
+        // driver or the app reads the system memory. Copies that were superseded or finished early to stay under
+        // cMaxPendingSystemMemoryCopies are no longer pending.
+        void ResolvePendingSystemMemoryCopies(Device& device);
+        bool HasPendingSystemMemoryCopies() const { return !m_pendingSystemMemoryCopies.IsEmpty(); }
+
         DXGI_FORMAT DepthStencilViewFormat() { return m_dsvFormat; }
 
         UINT64 ID(){ return m_ID; }
@@ -199,52 +210,21 @@ namespace D3D9on12
 
         // ---- Triangle fan index buffer cache methods ----        
         void GetTriFanIB(_Out_ InputBuffer& convertedIB, _In_ UINT baseIndexLocation, _In_ UINT indexCount, _In_ UINT ibStride);
-        bool IsTriangleFanIBCacheDirty(UINT baseIndexLocation);
 
 
         Device* GetParent() { return m_pParentDevice; }
     private:
-        class BindingTracker
-        {
-        public:
-            void Bind(UINT bindIndex) { m_boundIndices.push_back(bindIndex); }
-            void Unbind(UINT bindIndex)
-            {
-                // Doing an inefficient O(N) delete, betting that this is generally okay
-                // because a resource should generally only be bound at a couple of places
-                // at any given time.
-                if (m_boundIndices.size() > 5)
-                {
-                    INEFFICIENT_UNBINDING_ARRAY_DELETION();
-                }
-
-                for (size_t i = 0; i < m_boundIndices.size(); i++)
-                {
-                    if (bindIndex == m_boundIndices[i])
-                    {
-                        m_boundIndices.erase(m_boundIndices.begin() + i);
-                        return;
-                    }
-                }
-            }
-
-            bool IsBound() { return m_boundIndices.size() > 0; }
-            const std::vector<UINT> &GetBindingIndices() { return m_boundIndices; }
-        private:
-            std::vector<UINT> m_boundIndices;
-        };
-
-        BindingTracker m_SRVBindingTracker;
-        BindingTracker m_RTVBindingTracker;
-        BindingTracker m_DSVBindingTracker;
-        BindingTracker m_VBBindingTracker;
-        BindingTracker m_IBBindingTracker;
+        BindingTracker<MAX_SAMPLERS_STAGES> m_SRVBindingTracker;
+        BindingTracker<MAX_RENDER_TARGETS> m_RTVBindingTracker;
+        BindingTracker<1> m_DSVBindingTracker;
+        BindingTracker<MAX_VERTEX_STREAMS> m_VBBindingTracker;
+        BindingTracker<1> m_IBBindingTracker;
     public:
-        BindingTracker &GetRTVBindingTracker() { return m_RTVBindingTracker; }
-        BindingTracker &GetSRVBindingTracker() { return m_SRVBindingTracker; }
-        BindingTracker &GetDSVBindingTracker() { return m_DSVBindingTracker; }
-        BindingTracker &GetVBBindingTracker() { return m_VBBindingTracker; }
-        BindingTracker &GetIBBindingTracker() { return m_IBBindingTracker; }
+        BindingTracker<MAX_RENDER_TARGETS> &GetRTVBindingTracker() { return m_RTVBindingTracker; }
+        BindingTracker<MAX_SAMPLERS_STAGES> &GetSRVBindingTracker() { return m_SRVBindingTracker; }
+        BindingTracker<1> &GetDSVBindingTracker() { return m_DSVBindingTracker; }
+        BindingTracker<MAX_VERTEX_STREAMS> &GetVBBindingTracker() { return m_VBBindingTracker; }
+        BindingTracker<1> &GetIBBindingTracker() { return m_IBBindingTracker; }
 
         D3D12_SHADER_RESOURCE_VIEW_DESC GetShaderResourceViewDescForArraySlice(UINT8 arraySlice, UINT8 arraySize);
         UINT GetVidPnSourceId() const { return m_VidPnSourceId; }
@@ -253,23 +233,21 @@ namespace D3D9on12
         virtual void CreateUnderlyingResource( D3D12TranslationLayer::ResourceCreationArgs& underlyingResourceCreateArgs, _Inout_ D3DDDIARG_CREATERESOURCE2& createArgs );
         void CreateUnderlyingResource( D3D12TranslationLayer::ResourceCreationArgs& createArgs );
         Resource* m_pBackingShaderResource;
+        UINT64 m_backingShaderResourceGeneration = 0;
 
     private:
-        void UpdateTriangleFanIBCache(InputBuffer& newIBToStore, UINT baseIndexLocation);
-        // Buffer used to cache conversion between triangle fan and triangle list topologies. This allows us to avoid maping(and blocking the gpu) the index buffer in each draw call.
-        // This stores the TRIANGLE LIST CONVERTED INDEX BUFFER, actually enabling us to avoid the conversion as well.
-        struct TriangleFanIBCache {
-            TriangleFanIBCache() : 
-                m_baseIndexOffsetInBytes(0), 
-                m_dirtyFlag(true)
-            {}
-
-            InputBuffer m_TriangleFanConvertedTriangleListIndexBuffer;
-            UINT m_baseIndexOffsetInBytes;
-            bool m_dirtyFlag;
-        } m_TriFanIBCache;
-
-        void NotifyResourceChanged();
+        // Buffers used to cache conversion between triangle fan and triangle list topologies. This allows us to avoid maping(and blocking the gpu) the index buffer in each draw call.
+        // Each entry stores the TRIANGLE LIST CONVERTED INDEX BUFFER for one fan range, actually enabling us to avoid the conversion as well.
+        static const UINT cTriangleFanIBCacheSize = 4;
+        TriangleFanConversionCache<InputBuffer, cTriangleFanIBCacheSize> m_TriFanIBCache;
+
+        IndexBufferShadow m_indexBufferShadow;
+
+        void FillIndexBufferShadow(_In_ const void* pIndexData);
+        void UpdateIndexBufferShadowFromCopy(const ResourceCopyArgs& args);
+
+        // Drops cached fan conversions that read from the changed byte range
+        void NotifyResourceChanged(UINT offsetInBytes = 0, UINT sizeInBytes = UINT_MAX);
         bool IsSRGBCompatibleTexture();
 
         HRESULT InitInternal(
@@ -279,8 +257,10 @@ namespace D3D9on12
             bool DoNotCreateAsTypelessResource = false);
 
         HRESULT ClearResourceWithNoRenderTarget(_In_ UINT SubResourceIndex, _In_ const RECT* dstRects, _In_ UINT numRects, _In_ D3DCOLOR  Color);
-        void CreateRenderTargetViews(DXGI_FORMAT rtvFormat, bool GenerateSRGBRTV);
-        void CreateDepthStencilViews();
+        static D3DRESOURCETYPE GetStatisticsResourceType(const D3DDDI_RESOURCEFLAGS& flags);
+        void InitRenderTargetViews(DXGI_FORMAT rtvFormat, bool GenerateSRGBRTV);
+        D3D12TranslationLayer::RTV* CreateRenderTargetView(UINT subresourceIndex, bool srgbEnabled);
+        void CreateDepthStencilView(UINT dsvIndex);
         void CreateVideoDecoderOutputViews();
         void CreateVideoProcessorOutputViews();
 
@@ -320,6 +300,7 @@ namespace D3D9on12
 
         D3D12TranslationLayer::ResourceCreationArgs m_TranslationLayerCreateArgs;
 
+        // View caches, entries are created on first use by the Get*View accessors
         std::vector<std::unique_ptr<D3D12TranslationLayer::RTV>> m_renderTargetViews;
         std::vector<std::unique_ptr<D3D12TranslationLayer::RTV>> m_SRGBRenderTargetViews;
 
@@ -335,8 +316,21 @@ namespace D3D9on12
 
         bool m_isDecodeCompressedBuffer;
         bool m_isD3D9SystemMemoryPool; //System memory resources need to be updated at bind time
+
+        // What this resource was counted as in the device's DataLogger statistics
+        bool m_isTrackedInStatistics = false;
+        D3DRESOURCETYPE m_statisticsType = D3DRTYPE_SURFACE;
+        UINT64 m_statisticsSize = 0;
+        bool m_statisticsIsSystemMemory = false;
         
 
+        static const size_t cMaxFreeAsyncDiscardStorage = 2;
+        AsyncDiscardStoragePool<cMaxFreeAsyncDiscardStorage> m_asyncDiscardStorage;
+
+        size_t GetAsyncDiscardStorageSize(UINT subresourceIndex);
+        HRESULT LockAsyncTextureDiscard(UINT subresourceIndex, D3DDDI_LOCKFLAGS flags, const LockRange &lockRange, _Out_ VOID* &pSurfData, _Out_ UINT &pitch, _Out_ UINT &slicePitch, _Out_opt_ HANDLE *phCookie);
+        void RenameTexture(Device& device, std::unique_ptr<AsyncDiscardStorage> pStorage);
+
         struct LockData
         {
             LockData() : m_LockCount(0) {}
@@ -344,6 +338,8 @@ namespace D3D9on12
             D3DDDI_LOCKFLAGS m_Flags;
             D3D12_BOX m_Box;
             UINT m_LockCount;
+            // Map type used by each currently open synchronous lock, innermost last
+            std::vector<D3D12TranslationLayer::MAP_TYPE> m_MapTypes;
         };
 
         std::vector<LockData> m_lockData;
@@ -368,6 +364,26 @@ namespace D3D9on12
         AppLinearRepresentation m_appLinearRepresentation;
         PhysicalLinearRepresentation m_physicalLinearRepresentation;
 
+        // A copy into this system memory resource whose GPU copy into a staging resource has been recorded, but whose
+        // memcpy into the app's memory waits until the data is needed, so the copy call doesn't block on the GPU
+        struct PendingSystemMemoryCopy
+        {
+            unique_comptr<D3D12TranslationLayer::Resource> m_pStagingResource;
+            UINT m_sourceSubresourceIndex;
+            UINT m_destinationSubresourceIndex;
+            UINT m_numSubresources;
+            bool m_dimensionsCoverEntireResource;
+            UINT m_destinationX, m_destinationY, m_destinationZ;
+            D3D12_BOX m_sourceBox;
+            UINT8 m_bytesPerPixel;
+            std::vector<UINT> m_numRows;
+            std::vector<UINT> m_numSlices;
+        };
+
+        void CompleteSystemMemoryCopy(Device& device, D3D12TranslationLayer::Resource *pMappableResource, const PendingSystemMemoryCopy &copy);
+        static const size_t cMaxPendingSystemMemoryCopies = 4;
+        PendingCopyQueue<PendingSystemMemoryCopy, cMaxPendingSystemMemoryCopies> m_pendingSystemMemoryCopies;
+
         // Contains information about possible runtime extensions e.g. Hardware shadow maps.
         struct ResourceCompatibilityOptions
         {
@@ -0,0 +1,84 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    struct SamplerStateID
+    {
+        union
+        {
+            UINT Flags;
+            struct
+            {
+                UINT MagFilter : 4;
+                UINT MinFilter : 4;
+                UINT MipFilter : 4;
+                UINT AddressU : 3;
+                UINT AddressV : 3;
+                UINT AddressW : 3;
+                UINT MaxAnisotropy : 8;
+                UINT UseHardwareShadowMapping : 1;
+                UINT SwapRBBorderColors : 1;
+            };
+        };
+        UINT  BorderColor;
+        UINT  MaxMipLevel;
+        FLOAT MipLODBias;
+
+        SamplerStateID() : Flags(0),
+            BorderColor(0),
+            MaxMipLevel(0),
+            MipLODBias(0.0f)
+        {
+            C_ASSERT(sizeof(SamplerStateID) == sizeof(Flags) +
+                sizeof(BorderColor) +
+                sizeof(MaxMipLevel) +
+                sizeof(MipLODBias));
+        }
+        bool operator==(const SamplerStateID& rhs) const
+        {
+            return (this->Flags == rhs.Flags)
+                && (this->BorderColor == rhs.BorderColor)
+                && (this->MaxMipLevel == rhs.MaxMipLevel)
+                && (this->MipLODBias == rhs.MipLODBias);
+        }
+        bool operator!=(const SamplerStateID& rhs) const
+        {
+            return !(*this == rhs);
+        }
+        operator UINT() const
+        {
+            return this->Flags;
+        }
+    };
+
+    // Resets the fields that ConvertSampler's output doesn't depend on under the rest of the state, so samplers that
+    // only differ in those fields share a cache entry
+    static SamplerStateID CanonicalizeSamplerStateID(SamplerStateID samplerID)
+    {
+        if (samplerID.AddressU != D3DTADDRESS_BORDER &&
+            samplerID.AddressV != D3DTADDRESS_BORDER &&
+            samplerID.AddressW != D3DTADDRESS_BORDER)
+        {
+            samplerID.BorderColor = 0;
+            samplerID.SwapRBBorderColors = 0;
+        }
+
+        const bool isAnisotropic = samplerID.MinFilter == D3DTEXF_ANISOTROPIC || samplerID.MagFilter == D3DTEXF_ANISOTROPIC;
+        if (!isAnisotropic)
+        {
+            samplerID.MaxAnisotropy = 1;
+        }
+
+        // Without mipmapping the SRV only exposes mip 0, so the LOD only picks between minification and magnification.
+        // When both use the same filter the bias and clamp can't change the result.
+        if (samplerID.MipFilter == D3DTEXF_NONE && samplerID.MinFilter == samplerID.MagFilter && !isAnisotropic)
+        {
+            samplerID.MipLODBias = 0.0f;
+            samplerID.MaxMipLevel = 0;
+        }
+
+        return samplerID;
+    }
+};
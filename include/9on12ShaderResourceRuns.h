@@ -0,0 +1,27 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // Splits a mask of changed texture slots, indexed like the D3D9 sampler stages, into runs of consecutive slots and
+    // calls bindRun(first, count) for each, so every run is bound with a single SetShaderResources call. Runs stop at
+    // the end of the pixel samplers since the vertex samplers are a different stage.
+    template<typename BindRunFn>
+    inline void ForEachShaderResourceRun(UINT changedMask, BindRunFn&& bindRun)
+    {
+        unsigned long first;
+        while (_BitScanForward(&first, changedMask))
+        {
+            const UINT stageEnd = (first < MAX_PIXEL_SAMPLERS) ? MAX_PIXEL_SAMPLERS : MAX_SAMPLERS_STAGES;
+            UINT count = 0;
+            while (first + count < stageEnd && (changedMask & BIT(first + count)))
+            {
+                changedMask &= ~BIT(first + count);
+                count++;
+            }
+
+            bindRun(UINT(first), count);
+        }
+    }
+};
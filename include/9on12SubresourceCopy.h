@@ -0,0 +1,120 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // Copies numSlices slices of numRows rows of rowSizeInBytes each, honoring both pitches. Rows (and slices) that are
+    // contiguous in both the source and the destination are merged into a single memcpy, which lets the CRT use its
+    // wide copy loop on whole surfaces instead of one short copy per row.
+    inline void CopyRowsCoalesced(
+        _Out_ BYTE* pDst, SIZE_T dstRowPitch, SIZE_T dstSlicePitch,
+        _In_ const BYTE* pSrc, SIZE_T srcRowPitch, SIZE_T srcSlicePitch,
+        SIZE_T rowSizeInBytes, UINT numRows, UINT numSlices)
+    {
+        const bool rowsAreContiguous = dstRowPitch == rowSizeInBytes && srcRowPitch == rowSizeInBytes;
+        const SIZE_T sliceSizeInBytes = rowSizeInBytes * numRows;
+        if (rowsAreContiguous &&
+            (numSlices == 1 || (dstSlicePitch == sliceSizeInBytes && srcSlicePitch == sliceSizeInBytes)))
+        {
+            memcpy(pDst, pSrc, sliceSizeInBytes * numSlices);
+            return;
+        }
+
+        for (UINT z = 0; z < numSlices; ++z)
+        {
+            BYTE* pDstSlice = pDst + dstSlicePitch * z;
+            const BYTE* pSrcSlice = pSrc + srcSlicePitch * z;
+            if (rowsAreContiguous)
+            {
+                memcpy(pDstSlice, pSrcSlice, sliceSizeInBytes);
+                continue;
+            }
+
+            for (UINT y = 0; y < numRows; ++y)
+            {
+                memcpy(pDstSlice + dstRowPitch * y, pSrcSlice + srcRowPitch * y, rowSizeInBytes);
+            }
+        }
+    }
+
+    // Copies rows [firstRow, endRow) where rows are numbered across slices, i.e. row r is row (r % numRows) of slice
+    // (r / numRows)
+    inline void CopyRowRange(
+        _Out_ BYTE* pDst, SIZE_T dstRowPitch, SIZE_T dstSlicePitch,
+        _In_ const BYTE* pSrc, SIZE_T srcRowPitch, SIZE_T srcSlicePitch,
+        SIZE_T rowSizeInBytes, UINT numRows, UINT64 firstRow, UINT64 endRow)
+    {
+        while (firstRow < endRow)
+        {
+            const UINT64 z = firstRow / numRows;
+            const UINT y = static_cast<UINT>(firstRow % numRows);
+            const UINT rowsInSlice = static_cast<UINT>(min<UINT64>(numRows - y, endRow - firstRow));
+            CopyRowsCoalesced(
+                pDst + dstSlicePitch * z + dstRowPitch * y, dstRowPitch, dstSlicePitch,
+                pSrc + srcSlicePitch * z + srcRowPitch * y, srcRowPitch, srcSlicePitch,
+                rowSizeInBytes, rowsInSlice, 1);
+            firstRow += rowsInSlice;
+        }
+    }
+
+    static const UINT cMaxSubresourceCopyWorkers = 4;
+
+    // One worker per hardware thread, up to cMaxSubresourceCopyWorkers
+    inline UINT GetSubresourceCopyWorkerCount()
+    {
+        static const UINT cWorkerCount = min(std::thread::hardware_concurrency(), cMaxSubresourceCopyWorkers);
+        return cWorkerCount;
+    }
+
+    // Same as CopyRowsCoalesced, but copies of at least parallelThresholdInBytes are split into row ranges that are
+    // copied on up to maxWorkers (at most cMaxSubresourceCopyWorkers) threads, the calling thread included. A threshold
+    // of 0 disables the split. std::async hands the work to the CRT's thread pool on Windows, so no threads are created
+    // per copy there.
+    inline void CopyRowsParallel(
+        _Out_ BYTE* pDst, SIZE_T dstRowPitch, SIZE_T dstSlicePitch,
+        _In_ const BYTE* pSrc, SIZE_T srcRowPitch, SIZE_T srcSlicePitch,
+        SIZE_T rowSizeInBytes, UINT numRows, UINT numSlices,
+        UINT64 parallelThresholdInBytes, UINT maxWorkers)
+    {
+        const UINT64 totalRows = UINT64(numRows) * numSlices;
+        const UINT64 totalBytes = totalRows * rowSizeInBytes;
+        const UINT numWorkers = static_cast<UINT>(min<UINT64>(min(maxWorkers, cMaxSubresourceCopyWorkers), totalRows));
+        if (parallelThresholdInBytes == 0 || totalBytes < parallelThresholdInBytes || numWorkers <= 1)
+        {
+            CopyRowsCoalesced(pDst, dstRowPitch, dstSlicePitch, pSrc, srcRowPitch, srcSlicePitch, rowSizeInBytes, numRows, numSlices);
+            return;
+        }
+
+        auto copyChunk = [=](UINT chunk)
+        {
+            CopyRowRange(pDst, dstRowPitch, dstSlicePitch, pSrc, srcRowPitch, srcSlicePitch, rowSizeInBytes, numRows,
+                totalRows * chunk / numWorkers, totalRows * (chunk + 1) / numWorkers);
+        };
+
+        std::future<void> workers[cMaxSubresourceCopyWorkers - 1];
+        UINT numLaunched = 0;
+        try
+        {
+            for (; numLaunched < numWorkers - 1; numLaunched++)
+            {
+                workers[numLaunched] = std::async(std::launch::async, copyChunk, numLaunched + 1);
+            }
+        }
+        catch (...)
+        {
+            // Couldn't get another thread, the chunks that weren't handed out are copied here instead
+        }
+
+        for (UINT chunk = numLaunched + 1; chunk < numWorkers; chunk++)
+        {
+            copyChunk(chunk);
+        }
+        copyChunk(0);
+
+        for (UINT i = 0; i < numLaunched; i++)
+        {
+            workers[i].wait();
+        }
+    }
+};
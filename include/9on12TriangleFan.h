@@ -0,0 +1,306 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // Triangle fans are drawn as triangle lists: (i + 1, i + 2, 0) per triangle for non-indexed fans and
+    // (src[i + 1], src[i + 2], src[0]) for indexed ones.
+#if (_M_IX86 || _M_AMD64) && !defined(_M_HYBRID_X86_ARM64)
+    // The SIMD variants write three vectors at a time, which is exactly 8 (16-bit) or 4 (32-bit) triangles, and
+    // return how many triangles were written so the caller can finish the tail
+    inline UINT GenerateTriangleFanIndicesSIMD(_Out_writes_(primitiveCount * 3) UINT16* pDst, UINT primitiveCount)
+    {
+        __m128i v0 = _mm_setr_epi16(1, 2, 0, 2, 3, 0, 3, 4);
+        __m128i v1 = _mm_setr_epi16(0, 4, 5, 0, 5, 6, 0, 6);
+        __m128i v2 = _mm_setr_epi16(7, 0, 7, 8, 0, 8, 9, 0);
+        const __m128i inc0 = _mm_setr_epi16(8, 8, 0, 8, 8, 0, 8, 8);
+        const __m128i inc1 = _mm_setr_epi16(0, 8, 8, 0, 8, 8, 0, 8);
+        const __m128i inc2 = _mm_setr_epi16(8, 0, 8, 8, 0, 8, 8, 0);
+
+        UINT i = 0;
+        for (; i + 8 <= primitiveCount; i += 8)
+        {
+            __m128i* pOut = reinterpret_cast<__m128i*>(pDst + i * 3);
+            _mm_storeu_si128(pOut + 0, v0);
+            _mm_storeu_si128(pOut + 1, v1);
+            _mm_storeu_si128(pOut + 2, v2);
+            v0 = _mm_add_epi16(v0, inc0);
+            v1 = _mm_add_epi16(v1, inc1);
+            v2 = _mm_add_epi16(v2, inc2);
+        }
+        return i;
+    }
+
+    inline UINT GenerateTriangleFanIndicesSIMD(_Out_writes_(primitiveCount * 3) UINT32* pDst, UINT primitiveCount)
+    {
+        __m128i v0 = _mm_setr_epi32(1, 2, 0, 2);
+        __m128i v1 = _mm_setr_epi32(3, 0, 3, 4);
+        __m128i v2 = _mm_setr_epi32(0, 4, 5, 0);
+        const __m128i inc0 = _mm_setr_epi32(4, 4, 0, 4);
+        const __m128i inc1 = _mm_setr_epi32(4, 0, 4, 4);
+        const __m128i inc2 = _mm_setr_epi32(0, 4, 4, 0);
+
+        UINT i = 0;
+        for (; i + 4 <= primitiveCount; i += 4)
+        {
+            __m128i* pOut = reinterpret_cast<__m128i*>(pDst + i * 3);
+            _mm_storeu_si128(pOut + 0, v0);
+            _mm_storeu_si128(pOut + 1, v1);
+            _mm_storeu_si128(pOut + 2, v2);
+            v0 = _mm_add_epi32(v0, inc0);
+            v1 = _mm_add_epi32(v1, inc1);
+            v2 = _mm_add_epi32(v2, inc2);
+        }
+        return i;
+    }
+
+    // Requires SSSE3 for the byte shuffles, which every SSE4.2 capable CPU has
+    inline UINT ConvertTriangleFanIndicesSIMD(_Out_writes_(primitiveCount * 3) UINT16* pDst, _In_reads_(primitiveCount + 2) const UINT16* pSrc, UINT primitiveCount)
+    {
+        if (!g_cUseSSE4_2)
+        {
+            return 0;
+        }
+
+        const char z = static_cast<char>(0x80); // pshufb writes zero for these lanes, the hub index is or'd in afterwards
+        const __m128i shuffle0 = _mm_setr_epi8(0, 1, 2, 3, z, z, 2, 3, 4, 5, z, z, 4, 5, 6, 7);
+        const __m128i shuffle1 = _mm_setr_epi8(z, z, 6, 7, 8, 9, z, z, 8, 9, 10, 11, z, z, 10, 11);
+        const __m128i shuffle2 = _mm_setr_epi8(10, 11, z, z, 10, 11, 12, 13, z, z, 12, 13, 14, 15, z, z);
+        const __m128i hub = _mm_set1_epi16(static_cast<short>(pSrc[0]));
+        const __m128i hub0 = _mm_and_si128(hub, _mm_setr_epi16(0, 0, -1, 0, 0, -1, 0, 0));
+        const __m128i hub1 = _mm_and_si128(hub, _mm_setr_epi16(-1, 0, 0, -1, 0, 0, -1, 0));
+        const __m128i hub2 = _mm_and_si128(hub, _mm_setr_epi16(0, -1, 0, 0, -1, 0, 0, -1));
+
+        UINT i = 0;
+        for (; i + 8 <= primitiveCount; i += 8)
+        {
+            // a holds src[i + 1..i + 8], b holds src[i + 2..i + 9]
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i + 1));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i + 2));
+
+            __m128i* pOut = reinterpret_cast<__m128i*>(pDst + i * 3);
+            _mm_storeu_si128(pOut + 0, _mm_or_si128(_mm_shuffle_epi8(a, shuffle0), hub0));
+            _mm_storeu_si128(pOut + 1, _mm_or_si128(_mm_shuffle_epi8(a, shuffle1), hub1));
+            _mm_storeu_si128(pOut + 2, _mm_or_si128(_mm_shuffle_epi8(b, shuffle2), hub2));
+        }
+        return i;
+    }
+
+    inline UINT ConvertTriangleFanIndicesSIMD(_Out_writes_(primitiveCount * 3) UINT32* pDst, _In_reads_(primitiveCount + 2) const UINT32* pSrc, UINT primitiveCount)
+    {
+        const __m128i hub = _mm_set1_epi32(static_cast<int>(pSrc[0]));
+        const __m128i hubMask0 = _mm_setr_epi32(0, 0, -1, 0);
+        const __m128i hubMask1 = _mm_setr_epi32(0, -1, 0, 0);
+        const __m128i hubMask2 = _mm_setr_epi32(-1, 0, 0, -1);
+
+        UINT i = 0;
+        for (; i + 4 <= primitiveCount; i += 4)
+        {
+            // a holds src[i + 1..i + 4], b holds src[i + 2..i + 5]
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i + 1));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i + 2));
+
+            const __m128i out0 = _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 1, 0)); // a0 a1 -- a1
+            const __m128i out1 = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 2, 0, 2)); // a2 -- a2 a3
+            const __m128i out2 = _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 0)); // -- b2 b3 --
+
+            __m128i* pOut = reinterpret_cast<__m128i*>(pDst + i * 3);
+            _mm_storeu_si128(pOut + 0, _mm_or_si128(_mm_andnot_si128(hubMask0, out0), _mm_and_si128(hubMask0, hub)));
+            _mm_storeu_si128(pOut + 1, _mm_or_si128(_mm_andnot_si128(hubMask1, out1), _mm_and_si128(hubMask1, hub)));
+            _mm_storeu_si128(pOut + 2, _mm_or_si128(_mm_andnot_si128(hubMask2, out2), _mm_and_si128(hubMask2, hub)));
+        }
+        return i;
+    }
+#else
+    template<typename IndexType>
+    inline UINT GenerateTriangleFanIndicesSIMD(IndexType*, UINT) { return 0; }
+
+    template<typename IndexType>
+    inline UINT ConvertTriangleFanIndicesSIMD(IndexType*, const IndexType*, UINT) { return 0; }
+#endif
+
+    template<typename IndexType>
+    inline void FillTriangleFanIndexBuffer(_Out_writes_(primitiveCount * 3) IndexType* pDst, UINT primitiveCount)
+    {
+        for (UINT i = GenerateTriangleFanIndicesSIMD(pDst, primitiveCount); i < primitiveCount; i++)
+        {
+            pDst[i * 3 + 0] = static_cast<IndexType>(i + 1);
+            pDst[i * 3 + 1] = static_cast<IndexType>(i + 2);
+            pDst[i * 3 + 2] = 0;
+        }
+    }
+
+    template<typename IndexType>
+    inline void FillTriangleListFromTriangleFan(_Out_writes_(primitiveCount * 3) IndexType* pDst, _In_reads_(primitiveCount + 2) const IndexType* pSrc, UINT primitiveCount)
+    {
+        const IndexType hub = pSrc[0];
+        for (UINT i = ConvertTriangleFanIndicesSIMD(pDst, pSrc, primitiveCount); i < primitiveCount; i++)
+        {
+            pDst[i * 3 + 0] = pSrc[i + 1];
+            pDst[i * 3 + 1] = pSrc[i + 2];
+            pDst[i * 3 + 2] = hub;
+        }
+    }
+
+    // Triangle list conversions of triangle fans drawn from one index buffer. Meshes often draw several fans out of one
+    // index buffer, so a few ranges are kept, keyed by where the fan starts, its converted index count and its index
+    // size, and the least recently used one is evicted. Base vertex isn't part of the key, it's applied at draw time.
+    template<typename ConvertedBuffer, UINT cacheSize>
+    class TriangleFanConversionCache
+    {
+    public:
+        const ConvertedBuffer *Find(UINT indexOffsetInBytes, UINT indexCount, UINT indexStride)
+        {
+            for (Entry &entry : m_entries)
+            {
+                if (entry.m_isValid &&
+                    entry.m_baseIndexOffsetInBytes == indexOffsetInBytes &&
+                    entry.m_indexCount == indexCount &&
+                    entry.m_indexStride == indexStride)
+                {
+                    entry.m_lastUse = ++m_useCounter;
+                    return &entry.m_convertedBuffer;
+                }
+            }
+            return nullptr;
+        }
+
+        void Insert(const ConvertedBuffer &convertedBuffer, UINT indexOffsetInBytes, UINT indexCount, UINT indexStride)
+        {
+            // Reuse an empty entry if there is one, otherwise evict the least recently used range
+            Entry *pEntry = &m_entries[0];
+            for (Entry &entry : m_entries)
+            {
+                if (!entry.m_isValid)
+                {
+                    pEntry = &entry;
+                    break;
+                }
+                if (entry.m_lastUse < pEntry->m_lastUse)
+                {
+                    pEntry = &entry;
+                }
+            }
+
+            pEntry->m_convertedBuffer = convertedBuffer;
+            pEntry->m_baseIndexOffsetInBytes = indexOffsetInBytes;
+            pEntry->m_indexCount = indexCount;
+            pEntry->m_indexStride = indexStride;
+            pEntry->m_lastUse = ++m_useCounter;
+            pEntry->m_isValid = true;
+        }
+
+        // Drops the conversions that read from the changed byte range
+        void Invalidate(UINT offsetInBytes, UINT sizeInBytes)
+        {
+            const UINT64 changedStart = offsetInBytes;
+            const UINT64 changedEnd = changedStart + sizeInBytes;
+            for (Entry &entry : m_entries)
+            {
+                // A fan of N triangles reads N + 2 indices starting at the cached offset
+                const UINT64 sourceStart = entry.m_baseIndexOffsetInBytes;
+                const UINT64 sourceEnd = sourceStart + UINT64(entry.m_indexCount / 3 + 2) * entry.m_indexStride;
+                if (changedStart < sourceEnd && sourceStart < changedEnd)
+                {
+                    entry.m_isValid = false;
+                }
+            }
+        }
+
+    private:
+        struct Entry
+        {
+            ConvertedBuffer m_convertedBuffer;
+            UINT m_baseIndexOffsetInBytes = 0;
+            UINT m_indexCount = 0;
+            UINT m_indexStride = 0;
+            UINT64 m_lastUse = 0;
+            bool m_isValid = false;
+        };
+
+        Entry m_entries[cacheSize];
+        UINT64 m_useCounter = 0;
+    };
+
+    // Line list indices for wireframe triangle fans drawn with edge flags, generated once per (primitive count, edge
+    // flags) pattern. Past maxCachedPatterns the least recently used pattern is evicted. Fans of more than
+    // maxCachedPrimitiveCount triangles aren't cached at all, so the cache stays under
+    // maxCachedPatterns * (maxCachedPrimitiveCount * 2 + 4) indices and a rare huge fan doesn't evict the hot patterns.
+    template<size_t maxCachedPatterns, UINT maxCachedPrimitiveCount>
+    class WireframeTriangleFanIndexCache
+    {
+    public:
+        // The returned indices are valid until the next call
+        const std::vector<UINT> &GetIndices(UINT primitiveCount, UINT edgeFlags)
+        {
+            if (primitiveCount > maxCachedPrimitiveCount)
+            {
+                GenerateIndices(primitiveCount, edgeFlags, m_uncachedIndices);
+                return m_uncachedIndices;
+            }
+
+            const UINT64 key = (UINT64(primitiveCount) << 32) | edgeFlags;
+            auto result = m_map.find(key);
+            if (result != m_map.end())
+            {
+                m_lru.splice(m_lru.end(), m_lru, result->second.m_lruPosition);
+                return result->second.m_indices;
+            }
+
+            if (m_map.size() >= maxCachedPatterns)
+            {
+                m_map.erase(m_lru.front());
+                m_lru.pop_front();
+            }
+
+            CacheEntry &entry = m_map[key];
+            GenerateIndices(primitiveCount, edgeFlags, entry.m_indices);
+            entry.m_lruPosition = m_lru.insert(m_lru.end(), key);
+            return entry.m_indices;
+        }
+
+        size_t GetNumCachedPatterns() const { return m_map.size(); }
+        UINT64 GetNumGeneratedPatterns() const { return m_numGeneratedPatterns; }
+
+    private:
+        void GenerateIndices(UINT primitiveCount, UINT edgeFlags, std::vector<UINT> &indices)
+        {
+            m_numGeneratedPatterns++;
+            indices.clear();
+            indices.reserve(primitiveCount * 2 + 4); // 1 inner edge per triangle plus the 2 outer edges, 2 indices per edge
+            for (UINT primitive = 0; primitive < primitiveCount; ++primitive)
+            {
+                UINT primitiveEdgeFlags = edgeFlags >> primitive;
+                if (primitive == 0 && (primitiveEdgeFlags & 1))
+                {
+                    indices.push_back(0);
+                    indices.push_back(1);
+                }
+                if (primitiveEdgeFlags & 2)
+                {
+                    indices.push_back(primitive + 1);
+                    indices.push_back(primitive + 2);
+                }
+                if (primitive == primitiveCount - 1 && (primitiveEdgeFlags & 4))
+                {
+                    indices.push_back(primitive + 2);
+                    indices.push_back(0);
+                }
+            }
+        }
+
+        // Least recently used at the front
+        typedef std::list<UINT64> LRUListType;
+        struct CacheEntry
+        {
+            std::vector<UINT> m_indices;
+            LRUListType::iterator m_lruPosition;
+        };
+
+        std::unordered_map<UINT64, CacheEntry> m_map;
+        LRUListType m_lru;
+        std::vector<UINT> m_uncachedIndices;
+        UINT64 m_numGeneratedPatterns = 0;
+    };
+};
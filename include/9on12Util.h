@@ -113,6 +113,7 @@ __pragma(warning(suppress:4127)) /* conditional is constant due to constant macr
     { \
         DebugBreak();\
     } \
+    DataLogger::CountDDICall(); \
     if(RegistryConstants::g_cEnableDDISpew)\
     {\
         PrintDebugMessage(std::string(std::string("Command ID: ") + std::to_string(InterlockedIncrement(&g_CommandID))));\
@@ -563,6 +564,22 @@ __pragma(warning(suppress:4127)) /* conditional is constant due to constant macr
         ClipCopyRectsWithBoudingRect(rectToClip, pairedRect, resourceBounds);
     }
 
+    // Same as d3dx12's MemcpySubresource, but contiguous rows are merged into a single memcpy and large copies are split
+    // across threads, see CopyRowsParallel
+    static void MemcpySubresourceCoalesced(
+        _In_ const D3D12_MEMCPY_DEST* pDest,
+        _In_ const D3D12_SUBRESOURCE_DATA* pSrc,
+        SIZE_T rowSizeInBytes,
+        UINT numRows,
+        UINT numSlices)
+    {
+        CopyRowsParallel(
+            reinterpret_cast<BYTE*>(pDest->pData), pDest->RowPitch, pDest->SlicePitch,
+            reinterpret_cast<const BYTE*>(pSrc->pData), (SIZE_T)pSrc->RowPitch, (SIZE_T)pSrc->SlicePitch,
+            rowSizeInBytes, numRows, numSlices,
+            RegistryConstants::g_cParallelSubresourceCopyThreshold, GetSubresourceCopyWorkerCount());
+    }
+
     static const D3D12TranslationLayer::EQueryType g_cNoD3D12EquivalentQuery = (D3D12TranslationLayer::EQueryType) - 1;
     static D3D12TranslationLayer::EQueryType ConvertQueryType(D3DDDIQUERYTYPE type)
     {
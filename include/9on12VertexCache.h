@@ -0,0 +1,24 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+namespace D3D9on12
+{
+    // Post-transform vertex cache model reported through D3DQUERYTYPE_VCACHE. Current hardware doesn't have a strict
+    // FIFO, mesh optimizers only use the size as a hint so these match what each vendor's native D3D9 driver reported.
+    static const UINT g_cDefaultPostTransformVertexCacheSize = 16;
+
+    static UINT GetDefaultPostTransformVertexCacheSize(UINT vendorID)
+    {
+        switch (vendorID)
+        {
+        case 0x10DE: // NVIDIA
+        case 0x8086: // Intel
+            return 24;
+        case 0x1002: // AMD
+            return 14;
+        default:
+            return g_cDefaultPostTransformVertexCacheSize;
+        }
+    }
+};
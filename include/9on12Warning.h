@@ -14,7 +14,6 @@ namespace D3D9on12
         static const std::string g_cSystemMemoryBoundAsShaderResourceWarning = "Binding system memory resource as a shader resource. This path is a serious perf concern and should be reviewed if this gets hit outside of the HLK.";
         static const std::string g_cCopyToSystemMemoryWarning = "Copy is being called with system memory as the destination";
         static const std::string g_cIgnoringMultipleDirtyRectsWarning = "Suboptimally ignoring presents with multiple dirty rects";
-        static const std::string g_cInefficientUnbindingArrayDeletion = "A resource has a large amount of bindings causing inefficient O(N) deletions when being unbound";
     };
 
     static void PrintDebugMessage(std::string message)
@@ -48,6 +47,5 @@ namespace D3D9on12
 #define SYSTEM_MEMORY_RESOURCE_BOUND_AS_SHADER_RESOURCE_WARNING() PERFORMANCE_WARNING(WarningStrings::g_cSystemMemoryBoundAsShaderResourceWarning)
 #define COPY_TO_SYSTEM_MEMORY_WARNING() PERFORMANCE_WARNING(WarningStrings::g_cCopyToSystemMemoryWarning)
 #define IGNORING_MULTIPLE_DIRTY_RECTS() PERFORMANCE_WARNING(WarningStrings::g_cIgnoringMultipleDirtyRectsWarning)
-#define INEFFICIENT_UNBINDING_ARRAY_DELETION() PERFORMANCE_WARNING(WarningStrings::g_cInefficientUnbindingArrayDeletion)
 
 };
\ No newline at end of file
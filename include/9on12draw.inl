@@ -9,7 +9,9 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 namespace D3D9on12
 {
-    static HRESULT DrawProlog(Device& device, OffsetArg BaseVertexStart, UINT vertexCount, OffsetArg baseIndexLocation, UINT indexCount, D3DPRIMITIVETYPE primitiveType, UINT& instancesToDraw, bool &skipDraw)
+    // pAppendToPendingDraw is only passed for mergeable draws, it's set when the draw can be appended to the held back
+    // draw, in which case nothing is resolved since the pending draw's state is still current
+    static HRESULT DrawProlog(Device& device, OffsetArg BaseVertexStart, UINT minVertexIndex, UINT vertexCount, OffsetArg baseIndexLocation, UINT indexCount, D3DPRIMITIVETYPE primitiveType, UINT primitiveCount, UINT& instancesToDraw, bool &skipDraw, bool* pAppendToPendingDraw = nullptr)
     {
 
         if ((device.GetPipelineState().GetPixelStage().GetNumBoundRenderTargets() == 0 && device.GetPipelineState().GetPixelStage().GetDepthStencil() == nullptr) ||
@@ -21,24 +23,39 @@ namespace D3D9on12
         }
         skipDraw = false;
 
+        // The instance count is always in stream 0
+        UINT streamFrequence = device.GetStreamFrequency(0);
+
+        //This is how D3D9 conveyed instance count
+        instancesToDraw = (streamFrequence & D3DSTREAMSOURCE_INDEXEDDATA) ? streamFrequence &~D3DSTREAMSOURCE_INDEXEDDATA : 1;
+
         InputAssembly& ia = device.GetPipelineState().GetInputAssembly();
-        HRESULT hr = ia.UploadDeferredInputBufferData(device, BaseVertexStart, vertexCount, baseIndexLocation, indexCount);
+        HRESULT hr = ia.UploadDeferredInputBufferData(device, BaseVertexStart, minVertexIndex, vertexCount, instancesToDraw, baseIndexLocation, indexCount);
 
         CHECK_HR(hr);
         if (SUCCEEDED(hr))
         {
-            ia.SetPrimitiveTopology(device, primitiveType);
-            device.GetPipelineState().MarkPipelineStateNeeded();
+            const bool appendToPendingDraw = pAppendToPendingDraw && device.CanAppendToPendingDraw(primitiveType, indexCount > 0);
+            if (pAppendToPendingDraw)
+            {
+                *pAppendToPendingDraw = appendToPendingDraw;
+            }
 
-            hr = device.ResolveDeferredState(BaseVertexStart, baseIndexLocation);
-            CHECK_HR(hr);
-        }
+            if (!appendToPendingDraw)
+            {
+                device.FlushPendingDraw();
+                ia.SetPrimitiveTopology(device, primitiveType);
+                device.GetPipelineState().MarkPipelineStateNeeded();
 
-        // The instance count is always in stream 0
-        UINT streamFrequence = device.GetStreamFrequency(0);
+                hr = device.ResolveDeferredState(BaseVertexStart, baseIndexLocation);
+                CHECK_HR(hr);
+            }
+        }
 
-        //This is how D3D9 conveyed instance count
-        instancesToDraw = (streamFrequence & D3DSTREAMSOURCE_INDEXEDDATA) ? streamFrequence &~D3DSTREAMSOURCE_INDEXEDDATA : 1;
+        if (SUCCEEDED(hr))
+        {
+            device.GetDataLogger().AddDraw(primitiveType, primitiveCount, instancesToDraw);
+        }
 
         return hr;
     }
@@ -53,6 +70,7 @@ namespace D3D9on12
             device.GetPipelineState().SetIntzRestoreZWrite(false);
         }
         device.GetSystemMemoryAllocator().ClearDeferredDestroyedResource();
+        device.GetSystemMemoryIndexAllocator().ClearDeferredDestroyedResource();
         device.GetPipelineState().GetInputAssembly().ResetUploadBufferData();
         return S_OK;
     }
@@ -72,6 +90,12 @@ namespace D3D9on12
         OffsetArg baseVertexOffset = OffsetArg::AsOffsetInVertices(pDrawPrimitiveArg->VStart);
         OffsetArg baseIndexOffset = OffsetArg::AsOffsetInIndices(0);
 
+        const bool mergeableDraw = pDevice->IsMergeableDraw(pDrawPrimitiveArg->PrimitiveType);
+        if (!mergeableDraw)
+        {
+            pDevice->FlushPendingDraw();
+        }
+
         if (IsTriangleFan(pDrawPrimitiveArg->PrimitiveType))
         {
             if (pFlagBuffer)
@@ -87,7 +111,9 @@ namespace D3D9on12
         const UINT indexCount = 0;    
 
         bool skipDraw = false;
-        HRESULT hr = D3D9on12::DrawProlog(*pDevice, baseVertexOffset, vertexCount, baseIndexOffset, indexCount, pDrawPrimitiveArg->PrimitiveType, instanceCount, skipDraw);
+        bool appendToPendingDraw = false;
+        HRESULT hr = D3D9on12::DrawProlog(*pDevice, baseVertexOffset, 0, vertexCount, baseIndexOffset, indexCount, pDrawPrimitiveArg->PrimitiveType, pDrawPrimitiveArg->PrimitiveCount, instanceCount, skipDraw,
+            mergeableDraw ? &appendToPendingDraw : nullptr);
         CHECK_HR(hr);
 
         if (skipDraw)
@@ -97,12 +123,15 @@ namespace D3D9on12
 
         if (SUCCEEDED(hr))
         {
-            pDevice->GetContext().DrawInstanced(
-                CalcVertexCount(pDrawPrimitiveArg->PrimitiveType, pDrawPrimitiveArg->PrimitiveCount),
-                instanceCount,
-                baseVertexOffset.GetOffsetInVertices(),
-                0);
-
+            const UINT startVertex = baseVertexOffset.GetOffsetInVertices() - pDevice->GetPipelineState().GetInputAssembly().GetUploadedVertexRebase();
+            if (mergeableDraw)
+            {
+                pDevice->RecordMergeableDraw(appendToPendingDraw, pDrawPrimitiveArg->PrimitiveType, false, vertexCount, startVertex, 0);
+            }
+            else
+            {
+                pDevice->GetContext().DrawInstanced(vertexCount, instanceCount, startVertex, 0);
+            }
         }
 
         hr = DrawEpilogue(*pDevice);
@@ -134,7 +163,7 @@ namespace D3D9on12
         const UINT vertexCount = CalcVertexCount(pDrawPrimitiveArg->PrimitiveType, pDrawPrimitiveArg->PrimitiveCount);
 
         bool skipDraw;
-        HRESULT hr = DrawProlog(*pDevice, baseVertexOffset, vertexCount, baseIndexOffset, 0, pDrawPrimitiveArg->PrimitiveType, instanceCount, skipDraw);
+        HRESULT hr = DrawProlog(*pDevice, baseVertexOffset, 0, vertexCount, baseIndexOffset, 0, pDrawPrimitiveArg->PrimitiveType, pDrawPrimitiveArg->PrimitiveCount, instanceCount, skipDraw);
         CHECK_HR(hr);
         if (skipDraw)
         {
@@ -189,6 +218,17 @@ namespace D3D9on12
         }
         OffsetArg baseIndexOffset = OffsetArg::AsOffsetInBytes(pData->StartIndexOffset);
 
+        const bool mergeableDraw = pDevice->IsMergeableDraw(pData->PrimitiveType);
+        if (!mergeableDraw)
+        {
+            pDevice->FlushPendingDraw();
+        }
+
+        // First vertex the indices can reach, relative to the vertex offset handed to DrawProlog
+        const INT firstVertex = (INT)pData->MinIndex + drawOffset.GetOffsetInVertices();
+        Check9on12(firstVertex >= 0);
+        const UINT minVertexIndex = (UINT)max(firstVertex, 0);
+
         HRESULT hr = pDevice->GetPipelineState().GetInputAssembly().SetIndexBufferUM(*pDevice, dwIndicesSize, pIndexBuffer);
         CHECK_HR(hr);
         
@@ -196,13 +236,15 @@ namespace D3D9on12
         {
             if (pData->PrimitiveType == D3DPT_TRIANGLEFAN)
             {
-                return pDevice->DrawTriangleFanIndexed(baseVertexOffset, pData->NumVertices, baseIndexOffset, pData->PrimitiveCount);
+                return pDevice->DrawTriangleFanIndexed(baseVertexOffset, minVertexIndex, pData->NumVertices, baseIndexOffset, pData->PrimitiveCount);
             }
 
             UINT instanceCount = 1;
             const UINT indexCount = CalcVertexCount(pData->PrimitiveType, pData->PrimitiveCount);
             bool skipDraw;
-            hr = DrawProlog(*pDevice, baseVertexOffset, pData->NumVertices, baseIndexOffset, indexCount, pData->PrimitiveType, instanceCount, skipDraw);
+            bool appendToPendingDraw = false;
+            hr = DrawProlog(*pDevice, baseVertexOffset, minVertexIndex, pData->NumVertices, baseIndexOffset, indexCount, pData->PrimitiveType, pData->PrimitiveCount, instanceCount, skipDraw,
+                mergeableDraw ? &appendToPendingDraw : nullptr);
             CHECK_HR(hr);
             if (skipDraw)
             {
@@ -211,11 +253,16 @@ namespace D3D9on12
 
             if (SUCCEEDED(hr))
             {
-                pDevice->GetContext().DrawIndexedInstanced(indexCount,
-                    instanceCount,
-                    0,// offset will be added in the index buffer resolve,
-                    drawOffset.GetOffsetInVertices(),
-                    0);
+                const UINT startIndex = static_cast<UINT>(-pDevice->GetPipelineState().GetInputAssembly().GetUploadedIndexRebase());// offset will be added in the index buffer resolve, or baked into the upload
+                const INT baseVertex = drawOffset.GetOffsetInVertices() - pDevice->GetPipelineState().GetInputAssembly().GetUploadedVertexRebase();
+                if (mergeableDraw)
+                {
+                    pDevice->RecordMergeableDraw(appendToPendingDraw, pData->PrimitiveType, true, indexCount, startIndex, baseVertex);
+                }
+                else
+                {
+                    pDevice->GetContext().DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, 0);
+                }
             }
         }
 
@@ -270,7 +317,7 @@ namespace D3D9on12
 
         bool skipDraw;
         OffsetArg baseIndexOffset = OffsetArg::AsOffsetInIndices(0);
-        HRESULT hr = DrawProlog(*this, baseVertex, CalcVertexCount(D3DPT_TRIANGLEFAN, primitiveCount), baseIndexOffset, indexCount, D3DPT_TRIANGLEFAN, instanceCount, skipDraw);
+        HRESULT hr = DrawProlog(*this, baseVertex, 0, CalcVertexCount(D3DPT_TRIANGLEFAN, primitiveCount), baseIndexOffset, indexCount, D3DPT_TRIANGLEFAN, primitiveCount, instanceCount, skipDraw);
         CHECK_HR(hr);
 
         if (!skipDraw && SUCCEEDED(hr))
@@ -289,6 +336,8 @@ namespace D3D9on12
                 break;
             }
 
+            baseVertexVal -= GetPipelineState().GetInputAssembly().GetUploadedVertexRebase();
+
             GetContext().DrawIndexedInstanced(indexCount,
                 instanceCount,
                 baseIndexOffset.GetOffsetInIndices(),
@@ -307,32 +356,18 @@ namespace D3D9on12
 
     inline HRESULT Device::DrawWireframeTriangleFanWithEdgeFlags(_In_ OffsetArg baseVertex, _In_ UINT primitiveCount, _In_ UINT edgeFlags)
     {
-        UINT maxIndexCount = primitiveCount * 6; // 3 edges per triangle, 2 indices per edge
-        InputBuffer indexBuffer;
-        indexBuffer.InitAsPersistentTriangleFan(*this, maxIndexCount * sizeof(UINT), sizeof(UINT));
-        auto pIndices = reinterpret_cast<UINT*>(indexBuffer.GetTriangleFanMemory());
-
-        UINT indexCount = 0;
-        for (UINT primitive = 0; primitive < primitiveCount; ++primitive)
+        const std::vector<UINT> &lineListIndices = m_wireframeTriangleFanIndexCache.GetIndices(primitiveCount, edgeFlags);
+        const UINT indexCount = static_cast<UINT>(lineListIndices.size());
+        if (indexCount == 0)
         {
-            UINT primitiveEdgeFlags = edgeFlags >> primitive;
-            if (primitive == 0 && (primitiveEdgeFlags & 1))
-            {
-                pIndices[indexCount++] = 0;
-                pIndices[indexCount++] = 1;
-            }
-            if (primitiveEdgeFlags & 2)
-            {
-                pIndices[indexCount++] = primitive + 1;
-                pIndices[indexCount++] = primitive + 2;
-            }
-            if (primitive == primitiveCount - 1 && (primitiveEdgeFlags & 4))
-            {
-                pIndices[indexCount++] = primitive + 2;
-                pIndices[indexCount++] = 0;
-            }
+            // No edges are visible
+            return S_OK;
         }
 
+        // The indices are copied into the command list's upload allocator by DrawProlog, so no buffer is created per draw
+        InputBuffer indexBuffer;
+        indexBuffer.InitWithUploadData(*this, sizeof(UINT), lineListIndices.data());
+
         GetPipelineState().GetInputAssembly().PushNewIndexBuffer(indexBuffer);
 
         //Draw logic
@@ -341,7 +376,7 @@ namespace D3D9on12
 
         bool skipDraw;
         OffsetArg baseIndexOffset = OffsetArg::AsOffsetInIndices(0);
-        HRESULT hr = DrawProlog(*this, baseVertex, maxIndexCount, baseIndexOffset, indexCount, D3DPT_LINELIST, instanceCount, skipDraw);
+        HRESULT hr = DrawProlog(*this, baseVertex, 0, CalcVertexCount(D3DPT_TRIANGLEFAN, primitiveCount), baseIndexOffset, indexCount, D3DPT_LINELIST, indexCount / 2, instanceCount, skipDraw);
         CHECK_HR(hr);
 
         if (!skipDraw && SUCCEEDED(hr))
@@ -360,9 +395,11 @@ namespace D3D9on12
                 break;
             }
 
+            baseVertexVal -= GetPipelineState().GetInputAssembly().GetUploadedVertexRebase();
+
             GetContext().DrawIndexedInstanced(indexCount,
                 instanceCount,
-                baseIndexOffset.GetOffsetInIndices(),
+                baseIndexOffset.GetOffsetInIndices() - GetPipelineState().GetInputAssembly().GetUploadedIndexRebase(),
                 baseVertexVal,
                 0);
         }
@@ -376,7 +413,7 @@ namespace D3D9on12
         return hr;
     }
 
-    inline HRESULT Device::DrawTriangleFanIndexed(_In_ OffsetArg baseVertex, _In_ UINT vertexCount, _In_ OffsetArg baseIndexLocation, _In_ UINT primitiveCount)
+    inline HRESULT Device::DrawTriangleFanIndexed(_In_ OffsetArg baseVertex, _In_ UINT minVertexIndex, _In_ UINT vertexCount, _In_ OffsetArg baseIndexLocation, _In_ UINT primitiveCount)
     {
         //Update index count
         UINT indexCount = CalcVertexCount(D3DPT_TRIANGLELIST, primitiveCount);
@@ -399,6 +436,10 @@ namespace D3D9on12
 
         if (currentIndexBuffer.IsSystemMemory())
         {
+            if (currentIndexBuffer.GetAppResource())
+            {
+                currentIndexBuffer.GetAppResource()->ResolvePendingSystemMemoryCopies(*this);
+            }
             pSrcIndexBuffer = currentIndexBuffer.GetSystemMemoryBase();
             stride = currentIndexBuffer.GetStrideInBytes();
 
@@ -420,7 +461,7 @@ namespace D3D9on12
         // Draw logic
         UINT instanceCount = 1;
         bool skipDraw;
-        HRESULT hr = DrawProlog(*this, baseVertex, vertexCount, baseIndexLocation, indexCount, D3DPT_TRIANGLEFAN, instanceCount, skipDraw);
+        HRESULT hr = DrawProlog(*this, baseVertex, minVertexIndex, vertexCount, baseIndexLocation, indexCount, D3DPT_TRIANGLEFAN, primitiveCount, instanceCount, skipDraw);
         CHECK_HR(hr);
 
         if (!skipDraw && SUCCEEDED(hr))
@@ -428,7 +469,7 @@ namespace D3D9on12
             UINT const stream0Stride = GetPipelineState().GetInputAssembly().GetStream0Stride();
             Check9on12(stream0Stride > 0);
 
-            UINT baseVertexVal = 0;
+            INT baseVertexVal = 0;
             switch (baseVertex.m_type)
             {
             case OffsetType::OFFSET_IN_BYTES:
@@ -442,6 +483,8 @@ namespace D3D9on12
                 break;
             }
 
+            baseVertexVal -= GetPipelineState().GetInputAssembly().GetUploadedVertexRebase();
+
             GetContext().DrawIndexedInstanced(indexCount,
                 instanceCount,
                 0,
@@ -471,7 +514,8 @@ namespace D3D9on12
 
         UINT IndexCountPerInstance = CalcVertexCount(pDrawPrimitiveArg->PrimitiveType, pDrawPrimitiveArg->PrimitiveCount);
         UINT StartInstanceLocation = 0;
-        const UINT vertexCount = pDrawPrimitiveArg->MinIndex + pDrawPrimitiveArg->NumVertices;
+        const UINT minVertexIndex = pDrawPrimitiveArg->MinIndex;
+        const UINT vertexCount = pDrawPrimitiveArg->NumVertices;
 
         OffsetArg baseIndexOffset = OffsetArg::AsOffsetInIndices(pDrawPrimitiveArg->StartIndex);
         OffsetArg baseVertexOffset = OffsetArg::AsOffsetInVertices(pDrawPrimitiveArg->BaseVertexIndex);
@@ -479,12 +523,12 @@ namespace D3D9on12
         HRESULT hr = S_OK;
         if (pDrawPrimitiveArg->PrimitiveType == D3DPT_TRIANGLEFAN)
         {
-            hr = pDevice->DrawTriangleFanIndexed(baseVertexOffset, vertexCount, baseIndexOffset, pDrawPrimitiveArg->PrimitiveCount);
+            hr = pDevice->DrawTriangleFanIndexed(baseVertexOffset, minVertexIndex, vertexCount, baseIndexOffset, pDrawPrimitiveArg->PrimitiveCount);
         }
         else
         {
             bool skipDraw;
-            hr = DrawProlog(*pDevice, baseVertexOffset, vertexCount, baseIndexOffset, IndexCountPerInstance, pDrawPrimitiveArg->PrimitiveType, instanceCount, skipDraw);
+            hr = DrawProlog(*pDevice, baseVertexOffset, minVertexIndex, vertexCount, baseIndexOffset, IndexCountPerInstance, pDrawPrimitiveArg->PrimitiveType, pDrawPrimitiveArg->PrimitiveCount, instanceCount, skipDraw);
             CHECK_HR(hr);
 
             if (skipDraw)
@@ -497,8 +541,8 @@ namespace D3D9on12
                 pDevice->GetContext().DrawIndexedInstanced(
                     IndexCountPerInstance,
                     instanceCount,
-                    baseIndexOffset.GetOffsetInIndices(),
-                    baseVertexOffset.GetOffsetInVertices(),
+                    baseIndexOffset.GetOffsetInIndices() - pDevice->GetPipelineState().GetInputAssembly().GetUploadedIndexRebase(),
+                    baseVertexOffset.GetOffsetInVertices() - pDevice->GetPipelineState().GetInputAssembly().GetUploadedVertexRebase(),
                     StartInstanceLocation);
             }
         }
@@ -45,6 +45,10 @@
 #include <string>
 #include <stack>
 #include <deque>
+#include <list>
+#include <atomic>
+#include <thread>
+#include <future>
 
 
 #define BIT( x ) ( 1 << (x) )
@@ -191,6 +195,19 @@ DEFINE_GUID(DXVADDI_VideoProcD3D9On12CustomDeinterlaceDevice, 0xe064b480, 0xa8bb
 #include <9on12Warning.h>
 #include <9on12.h>
 #include <9on12Util.h>
+#include <9on12TriangleFan.h>
+#include <9on12BindingTracker.h>
+#include <9on12LockedRangeSet.h>
+#include <9on12SubresourceCopy.h>
+#include <9on12SamplerState.h>
+#include <9on12VertexCache.h>
+#include <9on12PendingDraw.h>
+#include <9on12IndexBufferShadow.h>
+#include <9on12PendingCopyQueue.h>
+#include <9on12AsyncDiscardStorage.h>
+#include <9on12QueryResultCache.h>
+#include <9on12PipelineStateDirtyFlags.h>
+#include <9on12ShaderResourceRuns.h>
 #include <9on12DDI.h>
 #include <9on12AppCompat.h>
 #include <9on12FastUploadAllocator.h>
@@ -629,6 +629,15 @@ namespace D3D9on12
             && driverVersion.HighPart < (31 << 16); //Major version is the 16 MSB of the HighPart
     }
 
+    UINT Adapter::GetPostTransformVertexCacheSize() const
+    {
+        if (RegistryConstants::g_cVertexCacheSize)
+        {
+            return RegistryConstants::g_cVertexCacheSize;
+        }
+        return GetDefaultPostTransformVertexCacheSize(m_HWIDs.vendorID);
+    }
+
     void Adapter::LogAdapterCreated( LUID *pluid, HRESULT hr )
     {
         //do nothing
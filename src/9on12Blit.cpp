@@ -289,13 +289,17 @@ namespace D3D9on12
         return subArgs;
     }
 
-    void Resource::CopyPrologue(Device& /*device*/, ResourceCopyArgs& /*args*/)
+    void Resource::CopyPrologue(Device& device, ResourceCopyArgs& args)
     {
+        // Copies from system memory read the app's memory directly
+        if (args.m_source.IsSystemMemory())
+        {
+            args.m_source.ResolvePendingSystemMemoryCopies(device);
+        }
     }
 
     void Resource::CopyToSystemMemoryResource(Device& device, ResourceCopyArgs& args)
     {
-        D3D12TranslationLayer::ImmediateContext& context = device.GetContext();
         Resource& source = args.m_source;
         Resource& destination = args.m_destination;
 
@@ -303,21 +307,60 @@ namespace D3D9on12
 
         Check9on12(destination.IsSystemMemory());
 
-        UINT sourceSubresourceIndex = args.m_sourceSubresourceIndex;
-        UINT destinationSubresourceIndex = args.m_destinationSubresourceIndex;
+        const DXGI_FORMAT SrcFormat = source.GetLogicalDesc().Format;
+
+        PendingSystemMemoryCopy copy = {};
+        copy.m_sourceSubresourceIndex = args.m_sourceSubresourceIndex;
+        copy.m_destinationSubresourceIndex = args.m_destinationSubresourceIndex;
+        copy.m_numSubresources = args.m_numSubresources;
+        copy.m_dimensionsCoverEntireResource = args.m_dimensionsCoverEntireResource;
+        copy.m_destinationX = args.m_destinationX;
+        copy.m_destinationY = args.m_destinationY;
+        copy.m_destinationZ = args.m_destinationZ;
+        copy.m_sourceBox = args.m_sourceBox;
+        copy.m_bytesPerPixel = (SrcFormat == DXGI_FORMAT_UNKNOWN) ? 1 : GetBytesPerUnit(SrcFormat);
+        for (UINT i = 0; i < args.m_numSubresources; i++)
+        {
+            copy.m_numRows.push_back(source.m_physicalLinearRepresentation.m_numRows[args.m_sourceSubresourceIndex + i]);
+            copy.m_numSlices.push_back(source.GetSubresourceFootprint(args.m_sourceSubresourceIndex + i).Footprint.Depth);
+        }
+
+        destination.m_pendingSystemMemoryCopies.DiscardSuperseded(copy, [&device](PendingSystemMemoryCopy &supersededCopy)
+        {
+            device.RecycleStagingReadbackResource(std::move(supersededCopy.m_pStagingResource));
+        });
 
-        unique_comptr<D3D12TranslationLayer::Resource> scopedMappableResource;
-        D3D12TranslationLayer::Resource *pMappableResource = source.GetUnderlyingResource();
-        if ((pMappableResource->AppDesc()->CPUAccessFlags() & D3D12TranslationLayer::RESOURCE_CPU_ACCESS_READ) == 0)
+        if ((source.GetUnderlyingResource()->AppDesc()->CPUAccessFlags() & D3D12TranslationLayer::RESOURCE_CPU_ACCESS_READ) != 0)
         {
-            scopedMappableResource = std::move(source.GetStagingCopy());
-            pMappableResource = scopedMappableResource.get();
+            // Mapping the source reads whatever it holds at that time, so this copy can't be deferred (or
+            // reordered ahead of earlier deferred ones)
+            destination.ResolvePendingSystemMemoryCopies(device);
+            destination.CompleteSystemMemoryCopy(device, source.GetUnderlyingResource(), copy);
         }
+        else
+        {
+            // Only the GPU copy into the staging resource is recorded here. Mapping it (and waiting on the GPU) is
+            // deferred until the system memory is actually read, usually when the app locks it.
+            copy.m_pStagingResource = std::move(source.GetStagingCopy());
+            destination.m_pendingSystemMemoryCopies.Push(std::move(copy), [&device, &destination](PendingSystemMemoryCopy &oldestCopy)
+            {
+                destination.CompleteSystemMemoryCopy(device, oldestCopy.m_pStagingResource.get(), oldestCopy);
+                device.RecycleStagingReadbackResource(std::move(oldestCopy.m_pStagingResource));
+            });
+        }
+    }  
+
+    void Resource::CompleteSystemMemoryCopy(Device& device, D3D12TranslationLayer::Resource *pMappableResource, const PendingSystemMemoryCopy &copy)
+    {
+        D3D12TranslationLayer::ImmediateContext& context = device.GetContext();
+        UINT sourceSubresourceIndex = copy.m_sourceSubresourceIndex;
+        UINT destinationSubresourceIndex = copy.m_destinationSubresourceIndex;
+        device.GetDataLogger().AddToCounter(DeviceStatistics::ReadbackWaits, 1);
 
         // Can't do a GPU copy to an upload heap so we have to memcpy it all over
-        for (UINT i = 0; i < args.m_numSubresources; i++)
+        for (UINT i = 0; i < copy.m_numSubresources; i++)
         {
-            D3D12_MEMCPY_DEST appDstData = destination.m_appLinearRepresentation.m_systemData[destinationSubresourceIndex];
+            D3D12_MEMCPY_DEST appDstData = m_appLinearRepresentation.m_systemData[destinationSubresourceIndex];
 
             D3D12TranslationLayer::MappedSubresource srcData = {};
             context.Map(pMappableResource, sourceSubresourceIndex, D3D12TranslationLayer::MAP_TYPE_READ, false , nullptr, &srcData);
@@ -328,37 +371,47 @@ namespace D3D9on12
             srcSubresourceData.SlicePitch = srcData.DepthPitch;
 
             SIZE_T BytesPerRow = appDstData.RowPitch;
-            UINT NumRows = source.m_physicalLinearRepresentation.m_numRows[sourceSubresourceIndex];
-            if (!args.m_dimensionsCoverEntireResource)
+            UINT NumRows = copy.m_numRows[i];
+            UINT NumSlices = copy.m_numSlices[i];
+            if (!copy.m_dimensionsCoverEntireResource)
             {
-                const DXGI_FORMAT SrcFormat = args.m_source.GetLogicalDesc().Format;
-                UINT8 BytesPerPixel = (SrcFormat == DXGI_FORMAT_UNKNOWN) ? 1 : GetBytesPerUnit(SrcFormat);
+                const UINT8 BytesPerPixel = copy.m_bytesPerPixel;
 
                 // Offset destination
                 reinterpret_cast<BYTE*&>(appDstData.pData) +=
-                    (args.m_destinationZ * appDstData.SlicePitch) +
-                    (args.m_destinationY * appDstData.RowPitch) +
-                    (args.m_destinationX * BytesPerPixel);
+                    (copy.m_destinationZ * appDstData.SlicePitch) +
+                    (copy.m_destinationY * appDstData.RowPitch) +
+                    (copy.m_destinationX * BytesPerPixel);
 
                 // Offset source
                 reinterpret_cast<BYTE*&>(srcData.pData) +=
-                    (args.m_sourceBox.front * srcData.DepthPitch) +
-                    (args.m_sourceBox.top * srcData.RowPitch) +
-                    (args.m_sourceBox.left * BytesPerPixel);
+                    (copy.m_sourceBox.front * srcData.DepthPitch) +
+                    (copy.m_sourceBox.top * srcData.RowPitch) +
+                    (copy.m_sourceBox.left * BytesPerPixel);
 
                 // Adjust how much data is copied
-                BytesPerRow = BytesPerPixel * (args.m_sourceBox.right - args.m_sourceBox.left);
-                NumRows = args.m_sourceBox.bottom - args.m_sourceBox.top;
+                BytesPerRow = BytesPerPixel * (copy.m_sourceBox.right - copy.m_sourceBox.left);
+                NumRows = copy.m_sourceBox.bottom - copy.m_sourceBox.top;
+                NumSlices = copy.m_sourceBox.back - copy.m_sourceBox.front;
             }
 
-            MemcpySubresource(&appDstData, &srcSubresourceData, BytesPerRow, NumRows, 1);
+            MemcpySubresourceCoalesced(&appDstData, &srcSubresourceData, BytesPerRow, NumRows, NumSlices);
 
             context.Unmap(pMappableResource, sourceSubresourceIndex, D3D12TranslationLayer::MAP_TYPE_READ, nullptr);
 
             sourceSubresourceIndex++;
             destinationSubresourceIndex++;
         }
-    }  
+    }
+
+    void Resource::ResolvePendingSystemMemoryCopies(Device& device)
+    {
+        m_pendingSystemMemoryCopies.Resolve([this, &device](PendingSystemMemoryCopy &copy)
+        {
+            CompleteSystemMemoryCopy(device, copy.m_pStagingResource.get(), copy);
+            device.RecycleStagingReadbackResource(std::move(copy.m_pStagingResource));
+        });
+    }
 
     void Resource::CopyResource(Device& device, ResourceCopyArgs& args)
     {
@@ -436,7 +489,15 @@ namespace D3D9on12
                 }
             }
         }
-        args.m_destination.NotifyResourceChanged();
+        args.m_destination.UpdateIndexBufferShadowFromCopy(args);
+        if (args.IsBufferBlit() && args.m_sourceBox.right > args.m_sourceBox.left)
+        {
+            args.m_destination.NotifyResourceChanged(args.m_destinationX, args.m_sourceBox.right - args.m_sourceBox.left);
+        }
+        else
+        {
+            args.m_destination.NotifyResourceChanged();
+        }
     }
 
     static inline D3D12_RECT ConvertBoxToRect(const D3D12_BOX& box)
@@ -733,6 +794,7 @@ namespace D3D9on12
             RETURN_E_INVALIDARG_AND_CHECK();
         }
 
+        pDevice->FlushPendingDraw();
         HRESULT hr = pDevice->DoBlit(pBltArgs, false);
 
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(hr);
@@ -807,6 +869,7 @@ namespace D3D9on12
 
         args.AsVolumeBlit(pBltArgs->DstX, pBltArgs->DstY, pBltArgs->DstZ, box);
 
+        pDevice->FlushPendingDraw();
         Resource::CopyResource(*pDevice, args);
         return S_OK;
     }
@@ -834,6 +897,7 @@ namespace D3D9on12
         ResourceCopyArgs args = ResourceCopyArgs(*pDestination, *pSource);
         args.AsBufferBlit(pBltArgs->Offset, pBltArgs->SrcRange);
 
+        pDevice->FlushPendingDraw();
         Resource::CopyResource(*pDevice, args);
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(hr);
     }
@@ -868,6 +932,7 @@ namespace D3D9on12
         ResourceCopyArgs args = ResourceCopyArgs(*pDestination, *pSource);
         args.AsTextureBlit(pBltArgs->DstPoint, pBltArgs->SrcRect, pBltArgs->CubeMapFace);
 
+        pDevice->FlushPendingDraw();
         Resource::CopyResource(*pDevice, args);
 
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(hr);
@@ -248,6 +248,7 @@ namespace D3D9on12
     {
         --m_frameNestCount;
 
+        m_pParentDevice->FlushPendingDraw();
         m_pUnderlyingVideoDecode->DecodeFrame(&m_inputArguments, &m_outputArguments);
 
         // now unmap frame arguments
@@ -297,6 +297,9 @@ namespace D3D9on12
         Device* pDevice = p9on12Resource->GetParent();
         auto& ImmCtx = pDevice->GetContext();
 
+        // The wait values below have to include a held back draw that uses the resource
+        pDevice->FlushPendingDraw();
+
         if (pResidencyHandle)
         {
             // Pin the resource while it is checked out to the caller.
@@ -348,6 +351,9 @@ namespace D3D9on12
         Device* pDevice = p9on12Resource->GetParent();
         auto& ImmCtx = pDevice->GetContext();
 
+        // A held back draw was issued before the caller's work and must not wait on it
+        pDevice->FlushPendingDraw();
+
         std::vector<D3D12TranslationLayer::DeferredWait> DeferredWaits;
         DeferredWaits.reserve(NumSync); // throw( bad_alloc )
 
@@ -422,6 +428,7 @@ namespace D3D9on12
     {
         D3D9on12_DDI_ENTRYPOINT_START(TRUE);
         Device* pDevice = Device::GetDeviceFromHandle(hDevice);
+        pDevice->FlushPendingDraw();
         auto clt = static_cast<D3D12TranslationLayer::COMMAND_LIST_TYPE>(commandListType);
         HRESULT hr = pDevice->GetContext().GetCommandListManager(clt)->PreExecuteCommandQueueCommand();
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR((hr));
@@ -438,6 +445,8 @@ namespace D3D9on12
 
     HRESULT Device::FlushWork(bool WaitOnCompletion, UINT /*FlushFlags*/)
     {
+        FlushPendingDraw();
+        m_dataLogger.AddToCounter(DeviceStatistics::Flushes, 1);
         if (WaitOnCompletion)
         {
             GetContext().WaitForCompletion(D3D12TranslationLayer::COMMAND_LIST_TYPE_ALL_MASK);
@@ -535,6 +544,7 @@ namespace D3D9on12
         m_d3d9APIVersion( CreateDeviceArgs.Version ),
         m_constantsManager( *this ),
         m_systemMemoryAllocator( *this, 32 * 1024 * 1024, 4, /*bDeferDestroyDuringRealloc*/ true ),
+        m_systemMemoryIndexAllocator( *this, 4 * 1024 * 1024, 4, /*bDeferDestroyDuringRealloc*/ true ),
         m_pVideoDevice( nullptr )
     {
         memcpy( (void*)&m_Callbacks, CreateDeviceArgs.pCallbacks, sizeof( m_Callbacks ) );
@@ -572,13 +582,119 @@ namespace D3D9on12
     {
         m_constantsManager.Destroy();
         m_systemMemoryAllocator.Destroy();
+        m_systemMemoryIndexAllocator.Destroy();
+        m_freeStagingReadbackResources.clear();
+        m_freeStagingReadbackBytes = 0;
         m_Adapter.DeviceDestroyed(this);
 
         return S_OK;
     }
 
+    static bool IsMatchingStagingReadbackResource(D3D12TranslationLayer::Resource &stagingResource, const D3D12TranslationLayer::ResourceCreationArgs &args)
+    {
+        const D3D12_RESOURCE_DESC &stagingDesc = stagingResource.Parent()->m_desc12;
+        const D3D12_RESOURCE_DESC &desc = args.m_desc12;
+        return stagingDesc.Dimension == desc.Dimension &&
+            stagingDesc.Width == desc.Width &&
+            stagingDesc.Height == desc.Height &&
+            stagingDesc.DepthOrArraySize == desc.DepthOrArraySize &&
+            stagingDesc.MipLevels == desc.MipLevels &&
+            stagingDesc.Format == desc.Format &&
+            stagingDesc.SampleDesc.Count == desc.SampleDesc.Count &&
+            stagingDesc.SampleDesc.Quality == desc.SampleDesc.Quality &&
+            stagingDesc.Layout == desc.Layout &&
+            stagingDesc.Flags == desc.Flags &&
+            stagingResource.AppDesc()->Format() == args.m_appDesc.Format();
+    }
+
+    unique_comptr<D3D12TranslationLayer::Resource> Device::AcquireStagingReadbackResource(const D3D12TranslationLayer::ResourceCreationArgs &args)
+    {
+        // Prefer the most recently recycled match, its memory is the most likely to still be warm
+        for (auto it = m_freeStagingReadbackResources.rbegin(); it != m_freeStagingReadbackResources.rend(); ++it)
+        {
+            if (IsMatchingStagingReadbackResource(*it->m_pResource, args))
+            {
+                unique_comptr<D3D12TranslationLayer::Resource> pStagingResource = std::move(it->m_pResource);
+                m_freeStagingReadbackBytes -= it->m_size;
+                m_freeStagingReadbackResources.erase(std::next(it).base());
+                return pStagingResource;
+            }
+        }
+
+        return D3D12TranslationLayer::Resource::CreateResource(
+            &GetContext(), args, D3D12TranslationLayer::ResourceAllocationContext::ImmediateContextThreadLongLived);
+    }
+
+    void Device::RecycleStagingReadbackResource(unique_comptr<D3D12TranslationLayer::Resource> pStagingResource)
+    {
+        if (!pStagingResource)
+        {
+            return;
+        }
+
+        const UINT64 size = pStagingResource->Parent()->m_heapDesc.SizeInBytes;
+        if (size > RegistryConstants::g_cStagingReadbackCacheSize)
+        {
+            return;
+        }
+
+        // Make room by releasing the least recently recycled resources
+        while (m_freeStagingReadbackBytes + size > RegistryConstants::g_cStagingReadbackCacheSize)
+        {
+            m_freeStagingReadbackBytes -= m_freeStagingReadbackResources.front().m_size;
+            m_freeStagingReadbackResources.pop_front();
+        }
+
+        m_freeStagingReadbackResources.push_back({ std::move(pStagingResource), size, m_stagingReadbackFrame });
+        m_freeStagingReadbackBytes += size;
+    }
+
+    void Device::TrimStagingReadbackResources()
+    {
+        // Readbacks that repeat every frame hand their resource back each frame, anything older is unlikely to be reused
+        while (!m_freeStagingReadbackResources.empty() &&
+            m_freeStagingReadbackResources.front().m_recycledFrame < m_stagingReadbackFrame)
+        {
+            m_freeStagingReadbackBytes -= m_freeStagingReadbackResources.front().m_size;
+            m_freeStagingReadbackResources.pop_front();
+        }
+        m_stagingReadbackFrame++;
+    }
+
+    bool Device::IsMergeableDraw(D3DPRIMITIVETYPE primitiveType)
+    {
+        // Instanced draws can't be concatenated
+        return RegistryConstants::g_cMergeUPDraws &&
+            PendingDraw::IsMergeablePrimitiveType(primitiveType) &&
+            (GetStreamFrequency(0) & D3DSTREAMSOURCE_INDEXEDDATA) == 0;
+    }
+
+    bool Device::CanAppendToPendingDraw(D3DPRIMITIVETYPE primitiveType, bool isIndexed)
+    {
+        // The app's shader constants aren't part of the dirty flags, if neither they nor anything else is dirty the
+        // state the pending draw was recorded with is unchanged
+        InputAssembly& inputAssembly = m_pipelineState.GetInputAssembly();
+        return m_pendingDraw.CanAppend(primitiveType, isIndexed, inputAssembly.GetVertexUploadBatchId(), inputAssembly.GetIndexUploadBatchId()) &&
+            m_pipelineState.AreOnlyInputBuffersDirty() &&
+            !m_constantsManager.AreAppConstantsDirty();
+    }
+
+    void Device::RecordMergeableDraw(bool appendToPendingDraw, D3DPRIMITIVETYPE primitiveType, bool isIndexed, UINT count, UINT start, INT baseVertex)
+    {
+        InputAssembly& inputAssembly = m_pipelineState.GetInputAssembly();
+        m_pendingDraw.Record(GetContext(), appendToPendingDraw, primitiveType, isIndexed, count, start, baseVertex,
+            inputAssembly.GetVertexUploadBatchId(), inputAssembly.GetIndexUploadBatchId());
+    }
+
+    void Device::FlushPendingDraw()
+    {
+        m_pendingDraw.Flush(GetContext());
+    }
+
     HRESULT Device::ResolveDeferredState(OffsetArg BaseVertexStart, OffsetArg BaseIndexStart)
     {
+        ScopedCounterTimer drawResolveTimer(m_dataLogger, DeviceStatistics::DrawResolveMicroseconds);
+
         //First resolve the pipeline state
         HRESULT hr = m_pipelineState.ResolveDeferredState(*this, BaseVertexStart, BaseIndexStart);
 
@@ -10,6 +10,7 @@ namespace D3D9on12
         m_size(size),
         m_alignmentRequired(alignment),
         m_spaceUsed(size),
+        m_lastAllocationEnd(size),
         m_pMappedAddress(nullptr)
     {
     }
@@ -28,6 +29,7 @@ namespace D3D9on12
     {
         SubBuffer bufferOut = {};
         const UINT alignedSize = Align(size, m_alignmentRequired);
+        m_parentDevice.GetDataLogger().AddToCounter(DeviceStatistics::UploadHeapBytes, size);
         const ULONG64 totalSize = alignedSize + static_cast<ULONG64>(m_spaceUsed);
 
         if (totalSize > static_cast<ULONG64>(m_size))
@@ -49,11 +51,43 @@ namespace D3D9on12
         bufferOut.m_offsetFromBase = static_cast<UINT>(offsetFromBase);
 
         m_spaceUsed += alignedSize;
+        m_lastAllocationEnd = bufferOut.m_offsetFromBase + size;
 
         assert(IsAligned(bufferOut.m_offsetFromBase, m_alignmentRequired));
         return bufferOut;
     }
 
+    auto FastUploadAllocator::AllocateAppended(UINT size, UINT baseOffset, UINT elementSize) -> SubBuffer
+    {
+        // Elements that divide the alignment (16-bit indices) are packed right behind the previous allocation, so
+        // back to back appends stay contiguous instead of being separated by the alignment padding
+        if (m_pResource && elementSize > 0 && m_alignmentRequired % elementSize == 0 &&
+            m_lastAllocationEnd >= baseOffset && (m_lastAllocationEnd - baseOffset) % elementSize == 0 &&
+            Align(static_cast<ULONG64>(m_lastAllocationEnd) + size, m_alignmentRequired) <= static_cast<ULONG64>(m_size))
+        {
+            m_parentDevice.GetDataLogger().AddToCounter(DeviceStatistics::UploadHeapBytes, size);
+            SubBuffer bufferOut(m_pResource.get(), (byte*)m_pMappedAddress + m_lastAllocationEnd, m_lastAllocationEnd);
+
+            m_lastAllocationEnd += size;
+            m_spaceUsed = Align(m_lastAllocationEnd, m_alignmentRequired);
+            return bufferOut;
+        }
+
+        // Padding is only possible when it keeps the allocation aligned, element sizes that divide the
+        // alignment are already a whole number of elements apart
+        if (m_pResource && m_spaceUsed >= baseOffset && elementSize > 0 && elementSize % m_alignmentRequired == 0)
+        {
+            const UINT padding = (elementSize - (m_spaceUsed - baseOffset) % elementSize) % elementSize;
+            const ULONG64 totalSize = static_cast<ULONG64>(m_spaceUsed) + padding + Align(size, m_alignmentRequired);
+            if (totalSize <= static_cast<ULONG64>(m_size))
+            {
+                m_spaceUsed += padding;
+            }
+        }
+
+        return Allocate(size);
+    }
+
     void FastUploadAllocator::Realloc()
     {
         if (m_bDeferDestroyDuringRealloc)
@@ -68,6 +102,7 @@ namespace D3D9on12
         m_parentDevice.GetContext().Map(m_pResource.get(), 0, D3D12TranslationLayer::MAP_TYPE_WRITE_DISCARD, false, nullptr, &MappedResult);
         m_pMappedAddress = MappedResult.pData;
         m_spaceUsed = 0;
+        m_lastAllocationEnd = 0;
     }
 
 };
\ No newline at end of file
@@ -103,11 +103,13 @@ namespace D3D9on12
 
     void Fence::Signal(UINT64 Value)
     {
+        m_pDevice->FlushPendingDraw();
         m_pDevice->GetContext().Signal(m_spUnderlyingFence.get(), Value);
     }
 
     void Fence::Wait(UINT64 Value)
     {
+        m_pDevice->FlushPendingDraw();
         m_pDevice->GetContext().Wait(m_spUnderlyingFence, Value);
     }
 
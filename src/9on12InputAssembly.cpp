@@ -67,6 +67,10 @@ namespace D3D9on12
         m_rasterStates(rasterStates),
         m_hasTLVertices(false),
         m_numBoundVBs(0),
+        m_uploadedVertexRebase(0),
+        m_uploadedIndexRebase(0),
+        m_vertexUploadBatchId(0),
+        m_indexUploadBatchId(0),
         m_topology(D3D_PRIMITIVE_TOPOLOGY_UNDEFINED),
         m_pInputLayout(nullptr)
     {
@@ -154,7 +158,7 @@ namespace D3D9on12
     {         
         if (m_isSystemMemory)
         {
-            return static_cast<UINT>(m_tempGPUBuffer.m_offsetFromBase);
+            return static_cast<UINT>(m_tempGPUBuffer.m_offsetFromBase - m_uploadElementOffset * m_bufferStride);
         }
         else
         {
@@ -162,41 +166,101 @@ namespace D3D9on12
         }
     }
 
-    HRESULT InputBuffer::Upload(Device& device, OffsetArg baseVertexIndex, UINT vertexCount)
+    // Copies the indices with bias added to each of them, unless a biased index would fall outside of the index format
+    template<typename IndexType>
+    static bool CopyBiasedIndices(_Out_writes_(indexCount) IndexType* pDst, _In_reads_(indexCount) const IndexType* pSrc, UINT indexCount, INT bias)
+    {
+        const IndexType stripCutValue = static_cast<IndexType>(~IndexType(0));
+        IndexType minIndex = stripCutValue;
+        IndexType maxIndex = 0;
+        for (UINT i = 0; i < indexCount; i++)
+        {
+            minIndex = min(minIndex, pSrc[i]);
+            maxIndex = max(maxIndex, pSrc[i]);
+        }
+
+        if (indexCount == 0 ||
+            static_cast<INT64>(minIndex) + bias < 0 ||
+            static_cast<INT64>(maxIndex) + bias >= static_cast<INT64>(stripCutValue))
+        {
+            return false;
+        }
+
+        for (UINT i = 0; i < indexCount; i++)
+        {
+            pDst[i] = static_cast<IndexType>(pSrc[i] + bias);
+        }
+        return true;
+    }
+
+    HRESULT InputBuffer::Upload(Device& device, FastUploadAllocator& allocator, UINT windowOffsetInBytes, UINT windowSizeInBytes, bool rebaseToWindow, UploadBatch* pBatch, INT indexBias)
     {
         Check9on12(m_isTriangleFanIndexBuffer == false);
         Check9on12(m_isSystemMemory);
-        
-        UINT32 drawOffset = 0;
 
-        switch (baseVertexIndex.m_type)
+        if (m_pAppProvidedResource)
         {
-            case OffsetType::OFFSET_IN_BYTES:
-                drawOffset = baseVertexIndex.GetOffsetInBytes();
-                break;
-            case OffsetType::OFFSET_IN_VERTICES:
-                drawOffset = baseVertexIndex.GetOffsetInVertices() * m_bufferStride;
-                break;
-            case OffsetType::OFFSET_IN_INDICES:
-                drawOffset = baseVertexIndex.GetOffsetInIndices() * m_bufferStride;
-                break;
-            default:
-                Check9on12(false);
-                break;
+            // Readbacks into the system memory resource are only finished when the data is needed
+            m_pAppProvidedResource->ResolvePendingSystemMemoryCopies(device);
         }
 
-        if (drawOffset >= m_sizeInBytes)
+        if (windowOffsetInBytes >= m_sizeInBytes)
         {
             return E_INVALIDARG;
         }
 
+        // If the draw can't be rebased, the bytes in front of the window are still allocated (but not copied)
+        // so that the draw's own start vertex/index lands on the uploaded data
+        const UINT32 leadingBytes = rebaseToWindow ? 0 : windowOffsetInBytes;
+
+        const bool appendToBatch = pBatch && rebaseToWindow && pBatch->m_pResource && pBatch->m_elementSize == m_bufferStride && m_bufferStride > 0;
+
+        m_tempGPUBuffer = appendToBatch ?
+            allocator.AllocateAppended(windowSizeInBytes, pBatch->m_baseOffset, m_bufferStride) :
+            allocator.Allocate(leadingBytes + windowSizeInBytes);
+        m_isUploadRebased = rebaseToWindow;
+        m_isUploadBiased = false;
+        m_uploadElementOffset = 0;
 
-        const UINT32 drawSize = vertexCount * m_bufferStride;
+        if (pBatch && rebaseToWindow)
+        {
+            const UINT offset = m_tempGPUBuffer.m_offsetFromBase;
+            if (appendToBatch &&
+                m_tempGPUBuffer.m_pResource == pBatch->m_pResource &&
+                offset >= pBatch->m_baseOffset &&
+                (offset - pBatch->m_baseOffset) % m_bufferStride == 0)
+            {
+                // Keep binding at the start of the batch and address this upload through the draw's start element
+                m_uploadElementOffset = (offset - pBatch->m_baseOffset) / m_bufferStride;
+            }
+            else
+            {
+                pBatch->m_pResource = m_tempGPUBuffer.m_pResource;
+                pBatch->m_baseOffset = offset;
+                pBatch->m_elementSize = m_bufferStride;
+                pBatch->m_id++;
+            }
+        }
 
-        m_tempGPUBuffer = device.GetSystemMemoryAllocator().Allocate(drawOffset + drawSize);
+        UINT32 maxCopySize = m_sizeInBytes - windowOffsetInBytes;
+        void* pDst = (byte*)m_tempGPUBuffer.m_pMappedAddress + leadingBytes;
+        const void* pSrc = (byte*)GetSystemMemoryBase() + windowOffsetInBytes;
+        if (indexBias != 0 && windowSizeInBytes <= maxCopySize)
+        {
+            if (m_bufferStride == sizeof(UINT16))
+            {
+                m_isUploadBiased = CopyBiasedIndices(static_cast<UINT16*>(pDst), static_cast<const UINT16*>(pSrc), windowSizeInBytes / sizeof(UINT16), indexBias);
+            }
+            else if (m_bufferStride == sizeof(UINT32))
+            {
+                m_isUploadBiased = CopyBiasedIndices(static_cast<UINT32*>(pDst), static_cast<const UINT32*>(pSrc), windowSizeInBytes / sizeof(UINT32), indexBias);
+            }
+        }
 
-        UINT32 maxCopySize = m_sizeInBytes - drawOffset;
-        memcpy((byte*)m_tempGPUBuffer.m_pMappedAddress + drawOffset, (byte*)GetSystemMemoryBase() + drawOffset, min(drawSize, maxCopySize));
+        if (!m_isUploadBiased)
+        {
+            memcpy(pDst, pSrc, min(windowSizeInBytes, maxCopySize));
+        }
 
         return S_OK;
     }
@@ -239,20 +303,18 @@ namespace D3D9on12
 
     void InputAssembly::CreateTriangleFanIndexBuffer(_In_ Device &device, _Out_ InputBuffer& targetBuffer, _In_ UINT& indexCount)
     {
-        typedef UINT32 TriFanUINT;        
-        const TriFanUINT bufferSize = indexCount * sizeof(TriFanUINT);
-
-        targetBuffer.InitAsPersistentTriangleFan(device, bufferSize, sizeof(TriFanUINT));
+        const UINT primitiveCount = indexCount / 3;
 
-        // TODO: Using a UINT32 to handle all cases, but if primitive count is smaller, we can use UINT16s as an optimization
-        typedef UINT32 TriFanUINT;
-        TriFanUINT *pFanIndexBuffer = (TriFanUINT *)targetBuffer.GetTriangleFanMemory();
-
-        for (UINT i = 0; i < indexCount; i += 3)
+        // The largest generated index is primitiveCount + 1, so 16-bit indices cover all but huge fans
+        if (primitiveCount + 1 <= UINT16_MAX)
+        {
+            targetBuffer.InitAsPersistentTriangleFan(device, indexCount * sizeof(UINT16), sizeof(UINT16));
+            FillTriangleFanIndexBuffer(static_cast<UINT16*>(targetBuffer.GetTriangleFanMemory()), primitiveCount);
+        }
+        else
         {
-            pFanIndexBuffer[i + 0] = i / 3 + 1;
-            pFanIndexBuffer[i + 1] = i / 3 + 2;
-            pFanIndexBuffer[i + 2] = 0;
+            targetBuffer.InitAsPersistentTriangleFan(device, indexCount * sizeof(UINT32), sizeof(UINT32));
+            FillTriangleFanIndexBuffer(static_cast<UINT32*>(targetBuffer.GetTriangleFanMemory()), primitiveCount);
         }
     }
 
@@ -263,38 +325,25 @@ namespace D3D9on12
     }
     
     // The output variable (convertedBuffer) is initialized from scratch using the bufferSize argument(persistent allocation, deleted in resource).    
+    // The converted indices keep the source index format, since a 16-bit source can never need 32-bit output.
     void InputAssembly::CreateTriangleListIBFromTriangleFanIB(_In_ Device &device, _In_ CONST void* pTriFanIndexBuffer, _In_ UINT indexBufferStride, _In_ UINT indexOffsetInBytes, _In_ UINT indexCount, _Out_ InputBuffer& convertedBuffer)
     {
-        void * pInputBuffer = (void*)(((BYTE*)pTriFanIndexBuffer) + indexOffsetInBytes);
+        const void * pInputBuffer = (const void*)(((const BYTE*)pTriFanIndexBuffer) + indexOffsetInBytes);
 
         assert(pInputBuffer != nullptr);
 
-        // TODO: Using a UINT32 to handle all cases, but if primitive count is smaller, we can use UINT16s as an optimization
-        typedef UINT32 TriFanUINT;
-
-        const TriFanUINT bufferSize = indexCount * sizeof(TriFanUINT);
-        
-        convertedBuffer.InitAsPersistentTriangleFan(device, bufferSize, sizeof(TriFanUINT));
-
-        TriFanUINT *pFanIndexBuffer = (TriFanUINT *)convertedBuffer.GetTriangleFanMemory();
+        const UINT primitiveCount = indexCount / 3;
 
-        for (UINT i = 0; i < indexCount; i += 3)
+        if (indexBufferStride == 2)
         {
-            if (indexBufferStride == 2)
-            {
-                const UINT16 *pIndexBuffer16 = static_cast<const UINT16 *>(pInputBuffer);
-                pFanIndexBuffer[i + 0] = static_cast<TriFanUINT>(pIndexBuffer16[i / 3 + 1]);
-                pFanIndexBuffer[i + 1] = static_cast<TriFanUINT>(pIndexBuffer16[i / 3 + 2]);
-                pFanIndexBuffer[i + 2] = static_cast<TriFanUINT>(pIndexBuffer16[0]);
-            }
-            else
-            {
-                Check9on12(indexBufferStride == 4);
-                const UINT32 *pIndexBuffer32 = static_cast<const UINT32 *>(pInputBuffer);
-                pFanIndexBuffer[i + 0] = static_cast<TriFanUINT>(pIndexBuffer32[i / 3 + 1]);
-                pFanIndexBuffer[i + 1] = static_cast<TriFanUINT>(pIndexBuffer32[i / 3 + 2]);
-                pFanIndexBuffer[i + 2] = static_cast<TriFanUINT>(pIndexBuffer32[0]);
-            }
+            convertedBuffer.InitAsPersistentTriangleFan(device, indexCount * sizeof(UINT16), sizeof(UINT16));
+            FillTriangleListFromTriangleFan(static_cast<UINT16*>(convertedBuffer.GetTriangleFanMemory()), static_cast<const UINT16*>(pInputBuffer), primitiveCount);
+        }
+        else
+        {
+            Check9on12(indexBufferStride == 4);
+            convertedBuffer.InitAsPersistentTriangleFan(device, indexCount * sizeof(UINT32), sizeof(UINT32));
+            FillTriangleListFromTriangleFan(static_cast<UINT32*>(convertedBuffer.GetTriangleFanMemory()), static_cast<const UINT32*>(pInputBuffer), primitiveCount);
         }
     }    
 
@@ -339,7 +388,7 @@ namespace D3D9on12
             
             // Please note that if the offset is not expressed in bytes, then aditionalOffset is zero.
 
-            INT aditionalOffset = (BaseIndexStart.m_type == OffsetType::OFFSET_IN_BYTES) ? BaseIndexStart.GetOffsetInBytes() : 0;
+            INT aditionalOffset = (BaseIndexStart.m_type == OffsetType::OFFSET_IN_BYTES && !ib.IsUploadRebased()) ? BaseIndexStart.GetOffsetInBytes() : 0;
             device.GetContext().IaSetIndexBuffer(ib.GetUnderlyingResource(), ibFormat, ib.GetOffsetInBytesD3D12() + aditionalOffset);
         }
         return hr;
@@ -377,8 +426,9 @@ namespace D3D9on12
 
         // Please note that if the offset is not expressed in bytes, then aditionalOffset is zero and the following code is equivalent to a simple loop over the streams.
 
-        INT aditionalOffset = (BaseVertexStart.m_type == OffsetType::OFFSET_IN_BYTES) ? BaseVertexStart.GetOffsetInBytes() : 0;
-        
+        // A range-exact upload already starts at the draw's first byte, so the offset must not be applied twice.
+        INT aditionalOffset = (BaseVertexStart.m_type == OffsetType::OFFSET_IN_BYTES && !m_inputStreams[0].IsUploadRebased()) ? BaseVertexStart.GetOffsetInBytes() : 0;
+
         size_t vbIndex = 0;
         
         vbs[vbIndex] = m_inputStreams[vbIndex].GetUnderlyingResource();
@@ -412,6 +462,9 @@ namespace D3D9on12
         if (IsSystemMemory())
         {
             m_tempGPUBuffer = {};
+            m_isUploadRebased = false;
+            m_isUploadBiased = false;
+            m_uploadElementOffset = 0;
         }
     }
 
@@ -423,44 +476,107 @@ namespace D3D9on12
             m_inputStreams[index].ResetUploadedData();
         }
         CurrentIndexBuffer().ResetUploadedData();
+        m_uploadedVertexRebase = 0;
+        m_uploadedIndexRebase = 0;
+        m_vertexUploadBatchId = 0;
+        m_indexUploadBatchId = 0;
     }
 
 
-    HRESULT InputAssembly::UploadDeferredInputBufferData(Device& device, OffsetArg baseVertexIndex, UINT vertexCount, OffsetArg baseIndexLocation, UINT indexCount)
+    HRESULT InputAssembly::UploadDeferredInputBufferData(Device& device, OffsetArg baseVertexIndex, UINT minVertexIndex, UINT vertexCount, UINT instanceCount, OffsetArg baseIndexLocation, UINT indexCount)
     {
         HRESULT hr = S_OK;
+        m_uploadedVertexRebase = 0;
+        m_uploadedIndexRebase = 0;
+        m_vertexUploadBatchId = 0;
+        m_indexUploadBatchId = 0;
 
-        auto& inputStream = m_inputStreams[0];
-
-        if (InputBufferNeedsUpload(0))
+        // If the offset was set in bytes, it only referenced the stream number zero. We can assume the other streams have zero offset.
+        INT baseVertex = 0;
+        UINT stream0OffsetInBytes = 0;
+        switch (baseVertexIndex.m_type)
         {
-            hr = inputStream.Upload(device, baseVertexIndex, vertexCount);
+        case OffsetType::OFFSET_IN_BYTES:
+            stream0OffsetInBytes = baseVertexIndex.GetOffsetInBytes();
+            break;
+        case OffsetType::OFFSET_IN_VERTICES:
+            baseVertex = baseVertexIndex.GetOffsetInVertices();
+            break;
+        case OffsetType::OFFSET_IN_INDICES:
+            baseVertex = baseVertexIndex.GetOffsetInIndices();
+            break;
+        default:
+            Check9on12(false);
+            break;
+        }
 
-            m_dirtyFlags.VertexBuffers |= BIT(0);
+        // Only the vertices the draw can reference (MinIndex..MinIndex+NumVertices for indexed draws) are uploaded
+        const INT firstVertex = baseVertex + (INT)minVertexIndex;
+        if (firstVertex < 0)
+        {
+            return E_INVALIDARG;
         }
-        
-        // If the offset was set in bytes, it only referenced the stream number zero. We can assume the other streams have zero offset.
-        const OffsetArg zeroOffset = OffsetArg::AsOffsetInBytes(0);
-        const OffsetArg &realOffset = (baseVertexIndex.m_type == OffsetType::OFFSET_IN_BYTES) ? zeroOffset : baseVertexIndex;
 
-        if (SUCCEEDED(hr))
+        // Uploaded windows can only be bound at offset zero if the draw itself is rebased onto them, which is only
+        // possible when no per-vertex stream comes from a GPU buffer that still needs the original start vertex
+        bool rebaseDraw = true;
+        UINT perVertexUploadCount = 0;
+        for (UINT index = 0; index < MAX_VERTEX_STREAMS; index++)
         {
-            for (UINT index = 1; index < MAX_VERTEX_STREAMS; index++)
+            if ((m_pInputLayout->GetStreamMask() & BIT(index)) != 0 &&
+                (device.GetStreamFrequency(index) & D3DSTREAMSOURCE_INSTANCEDATA) == 0)
             {
-                if (InputBufferNeedsUpload(index))
+                if (!m_inputStreams[index].IsSystemMemory())
                 {
-                    hr = m_inputStreams[index].Upload(device, realOffset, vertexCount);
-
-                    m_dirtyFlags.VertexBuffers |= BIT(index);
+                    rebaseDraw = false;
+                    break;
                 }
+                perVertexUploadCount++;
+            }
+        }
 
-                if (FAILED(hr))
+        // All rebased streams share the draw's start vertex, so only a single uploaded stream (the UP case) can be
+        // appended to the running batch
+        UploadBatch* pVertexBatch = (rebaseDraw && perVertexUploadCount == 1) ? &m_vertexUploadBatch : nullptr;
+        INT batchedElementOffset = 0;
+
+        for (UINT index = 0; index < MAX_VERTEX_STREAMS; index++)
+        {
+            if (InputBufferNeedsUpload(index))
+            {
+                InputBuffer& inputStream = m_inputStreams[index];
+                const UINT stride = inputStream.GetStrideInBytes();
+                const UINT streamFrequency = device.GetStreamFrequency(index);
+
+                if (streamFrequency & D3DSTREAMSOURCE_INSTANCEDATA)
                 {
-                    break;
+                    // Instance data isn't offset by the start vertex, it's indexed by instance / step rate
+                    const UINT stepRate = max(streamFrequency & ~D3DSTREAMSOURCE_INSTANCEDATA, 1u);
+                    const UINT elementCount = (instanceCount + stepRate - 1) / stepRate;
+                    hr = inputStream.Upload(device, device.GetSystemMemoryAllocator(), 0, elementCount * stride, true);
+                    device.GetDataLogger().AddUploadedBytes(D3DRTYPE_VERTEXBUFFER, elementCount * stride);
+                }
+                else
+                {
+                    const UINT windowOffset = (index == 0 ? stream0OffsetInBytes : 0) + firstVertex * stride;
+                    hr = inputStream.Upload(device, device.GetSystemMemoryAllocator(), windowOffset, vertexCount * stride, rebaseDraw, pVertexBatch);
+                    device.GetDataLogger().AddUploadedBytes(D3DRTYPE_VERTEXBUFFER, vertexCount * stride);
+                    batchedElementOffset = inputStream.GetUploadElementOffset();
+                    m_vertexUploadBatchId = pVertexBatch ? pVertexBatch->m_id : 0;
                 }
 
-                index++;
+                m_dirtyFlags.VertexBuffers |= BIT(index);
             }
+
+            if (FAILED(hr))
+            {
+                break;
+            }
+        }
+
+        if (SUCCEEDED(hr) && rebaseDraw && perVertexUploadCount > 0)
+        {
+            m_uploadedVertexRebase = firstVertex - batchedElementOffset;
         }
 
         if (SUCCEEDED(hr) && indexCount > 0)
@@ -472,13 +588,28 @@ namespace D3D9on12
                 // Triangle fans are uploaded on creation
                 if (currentIB.IsTriangleFan() == false)
                 {
-                    hr = currentIB.Upload(device, baseIndexLocation, indexCount);
+                    const UINT indexStride = currentIB.GetStrideInBytes();
+                    const bool offsetInBytes = (baseIndexLocation.m_type == OffsetType::OFFSET_IN_BYTES);
+                    const UINT startIndex = offsetInBytes ? 0 : baseIndexLocation.GetOffsetInIndices();
+                    const UINT indexOffset = offsetInBytes ? baseIndexLocation.GetOffsetInBytes() : startIndex * indexStride;
+
+                    // Baking the vertex rebase into batched indices gives every draw of the batch the same base vertex, which
+                    // lets consecutive UP draws be merged. Indices get their own allocator so that they stay contiguous.
+                    const INT indexBias = (m_vertexUploadBatchId != 0 && RegistryConstants::g_cMergeUPDraws) ? -m_uploadedVertexRebase : 0;
+                    hr = currentIB.Upload(device, device.GetSystemMemoryIndexAllocator(), indexOffset, indexCount * indexStride, true, &m_indexUploadBatch, indexBias);
+                    device.GetDataLogger().AddUploadedBytes(D3DRTYPE_INDEXBUFFER, indexCount * indexStride);
+                    m_uploadedIndexRebase = (INT)startIndex - (INT)currentIB.GetUploadElementOffset();
+                    m_indexUploadBatchId = m_indexUploadBatch.m_id;
+                    if (currentIB.IsUploadBiased())
+                    {
+                        m_uploadedVertexRebase = 0;
+                    }
                 }
 
                 m_dirtyFlags.IndexBuffer = true;
             }
         }
-        
+
         CHECK_HR(hr);
         return hr;
     }
@@ -52,6 +52,7 @@ namespace D3D9on12
             RETURN_E_INVALIDARG_AND_CHECK();
         }
 
+        pDevice->FlushPendingDraw();
         delete(pInputLayout);
 
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(S_OK);
@@ -53,12 +53,64 @@ namespace D3D9on12
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(S_OK);
     }
 
+    // Render states that must reach the switch in SetRenderState even when set to the value they already hold: values
+    // that encode a command (RESZ and alpha to coverage) and legacy states remapped onto render or texture stage
+    // states that may have been changed directly since. Every other state only stores its value, so a redundant set
+    // can be dropped before any dirty flag is raised.
+    struct RenderStateTable
+    {
+        bool m_forwardRedundantSets[D3DHAL_MAX_RSTATES];
+    };
+
+    static constexpr RenderStateTable BuildRenderStateTable()
+    {
+        RenderStateTable table = {};
+        constexpr DWORD alwaysForwardedStates[] =
+        {
+            D3DRS_POINTSIZE,
+            D3DRS_ADAPTIVETESS_Y,
+            D3DRENDERSTATE_TEXTUREMAPBLEND,
+            D3DRENDERSTATE_TEXTUREADDRESS,
+            D3DRENDERSTATE_TEXTUREADDRESSU,
+            D3DRENDERSTATE_TEXTUREADDRESSV,
+            D3DRENDERSTATE_MIPMAPLODBIAS,
+            D3DRENDERSTATE_BORDERCOLOR,
+            D3DRENDERSTATE_ANISOTROPY,
+            D3DRENDERSTATE_TEXTUREMAG,
+            D3DRENDERSTATE_TEXTUREMIN,
+            D3DRENDERSTATE_TEXTUREHANDLE,
+            D3DRENDERSTATE_WRAPU,
+            D3DRENDERSTATE_WRAPV,
+            D3DRENDERSTATE_SCENECAPTURE,
+        };
+        for (DWORD state : alwaysForwardedStates)
+        {
+            table.m_forwardRedundantSets[state] = true;
+        }
+        return table;
+    }
+
+    static constexpr RenderStateTable g_cRenderStateTable = BuildRenderStateTable();
+
     void PipelineState::SetRenderState(Device& device, DWORD dwState, DWORD dwValue)
     {
-        //TODO: early out for redundant state sets
+        if (dwState >= D3DHAL_MAX_RSTATES)
+        {
+            Check9on12(false);
+            return;
+        }
+
+        // Apps commonly re-send the same state many times a frame
+        if (m_renderStatesSet[dwState] &&
+            m_dwRenderStates[dwState] == dwValue &&
+            !g_cRenderStateTable.m_forwardRedundantSets[dwState])
+        {
+            return;
+        }
 
         // Set the render state value  
         m_dwRenderStates[dwState] = dwValue;
+        m_renderStatesSet[dwState] = true;
         switch (dwState)
         {
             // Rasterizer states  
@@ -290,7 +342,14 @@ namespace D3D9on12
             return;
         }
 
+        // Every texture stage state handler only depends on the new value, so re-sending the stored value changes nothing
+        if (m_textureStageStatesSet[dwStage][dwState] && m_dwTextureStageStates[dwStage][dwState] == dwValue)
+        {
+            return;
+        }
+
         m_dwTextureStageStates[dwStage][dwState] = dwValue;
+        m_textureStageStatesSet[dwStage][dwState] = true;
 
         SamplerStateID& samplerID = m_pixelStage.GetSamplerID(dwStage);
 
@@ -462,6 +521,14 @@ namespace D3D9on12
         HRESULT hr = S_OK;
         if (!m_bNeedsPipelineState) return S_OK;
 
+        const bool isVertexStartInBytes = BaseVertexStart.m_type == OffsetType::OFFSET_IN_BYTES;
+        const bool isIndexStartInBytes = BaseIndexStart.m_type == OffsetType::OFFSET_IN_BYTES;
+        if (m_dirtyFlags.CanSkipResolve(isVertexStartInBytes, isIndexStartInBytes))
+        {
+            device.GetConstantsManager().BindShaderConstants();
+            return S_OK;
+        }
+
         hr = m_inputAssembly.ResolveDeferredState(device, m_PSODesc, BaseVertexStart, BaseIndexStart);
         CHECK_HR(hr);
 
@@ -492,22 +559,7 @@ namespace D3D9on12
             }
         }
 
-        m_dirtyFlags.Clear();
-
-        // If this draw call was made with byte offsetting, we bake this offset in to the bounded VB/IB.
-        // We must clean this up for draws that won't expect this additional offset in the VB/IB
-        
-        if (BaseVertexStart.m_type == OffsetType::OFFSET_IN_BYTES)            
-        {
-            m_dirtyFlags.VertexBuffers |= BIT(0);
-        }
-
-        if (BaseIndexStart.m_type == OffsetType::OFFSET_IN_BYTES)
-        {
-            m_dirtyFlags.IndexBuffer = true;
-        }
-
-        m_dirtyFlags.Textures |= textureDirtyMaskToKeep;
+        m_dirtyFlags.ClearAfterResolve(isVertexStartInBytes, isIndexStartInBytes, textureDirtyMaskToKeep);
 
         device.GetConstantsManager().BindShaderConstants();
         CHECK_HR(hr);
@@ -29,6 +29,7 @@ namespace D3D9on12
             m_cache.m_accessOrder.splice(m_cache.m_accessOrder.begin(), m_cache.m_accessOrder, cacheEntry->m_accessOrderPos);
             cacheEntry->m_accessOrderPos = m_cache.m_accessOrder.begin();
             cacheEntry->m_timestamp = timestamp;
+            m_device.GetDataLogger().AddToCounter(DeviceStatistics::PipelineStateCacheHits, 1);
             return cacheEntry->m_pPipelineState.get();
         }
 
@@ -61,6 +62,7 @@ namespace D3D9on12
 
         // No cached PSO exists, time to create one
         cacheEntry->m_pPipelineState.reset(new D3D12TranslationLayer::PipelineState(&m_device.GetContext(), desc)); // throw( bad_alloc, _com_error )
+        m_device.GetDataLogger().AddToCounter(DeviceStatistics::PipelineStateCompilations, 1);
 
         Check9on12(pPS->GetD3D9ParentShader());
         Check9on12(pVS->GetD3D9ParentShader());
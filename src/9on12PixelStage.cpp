@@ -180,6 +180,8 @@ namespace D3D9on12
     {
         memset(m_pRenderTargets, 0, sizeof(m_pRenderTargets));
         memset(m_shaderResources, 0, sizeof(m_shaderResources));
+        memset(m_pBoundSRVs, 0, sizeof(m_pBoundSRVs));
+        memset(m_pBoundSRVResources, 0, sizeof(m_pBoundSRVResources));
         memset(m_SRGBTexture, 0, sizeof(m_SRGBTexture));
         for (auto &componentMapping : m_rtvShaderComponentMapping)
         {
@@ -193,12 +195,104 @@ namespace D3D9on12
         return S_OK;
     }
 
-    void PixelStage::MarkSRVIndicesDirty(const std::vector<UINT> &indices)
+    void PixelStage::MarkSRVIndicesDirty(UINT indexMask)
     {
-        for (UINT index : indices)
+        m_dirtyFlags.Textures |= indexMask;
+    }
+
+    void PixelStage::ClearBoundShaderResourceViews(Resource* pResource)
+    {
+        for (UINT i = 0; i < MAX_SAMPLERS_STAGES; i++)
         {
-            m_dirtyFlags.Textures |= BIT(index);
+            if (m_pBoundSRVResources[i] == pResource)
+            {
+                m_pBoundSRVs[i] = nullptr;
+                m_pBoundSRVResources[i] = nullptr;
+            }
+
+            // A new resource at the same address mustn't inherit this one's hazard check
+            if (m_srvHazardStates[i].m_pResource == pResource)
+            {
+                m_srvHazardStates[i] = SRVHazardState();
+            }
+        }
+    }
+
+    void PixelStage::CheckSRVHazard(Device& device, UINT textureIndex, Resource* pResource, SRVHazardState& hazard)
+    {
+        DWORD shaderRegister;
+        D3D12TranslationLayer::EShaderStage shaderStage;
+        ConvertDX9TextureIndexToShaderStageAndRegisterIndex(textureIndex, shaderStage, shaderRegister);
+
+        // Certain apps expect the driver to automatically unbind resources as SRVs when they are bound as RTVs
+        // Examples inclue Alan Wake and Valkyrie Chronicles
+        bool HideSRV = pResource->GetDSVBindingTracker().IsBound() && GetDepthStencilStateID().ZWriteEnable;
+
+        // resources with INTZ surface format, set ZWriteEnable to false instead of hiding SRV
+        if (!g_AppCompatInfo.DisableIntzDSVFix && HideSRV && (pResource->GetD3DFormat() == D3DFMT_INTZ))
+        {
+            HideSRV = false;
+            SetDepthStencilState(device, D3DRS_ZWRITEENABLE, 0);
+            device.GetPipelineState().SetIntzRestoreZWrite(true);
+        }
+
+        hazard.m_boundAsRenderTarget = false;
+        hazard.m_sampleBackingCopy = false;
+        if (!HideSRV && pResource->GetRTVBindingTracker().IsBound())
+        {
+            HideSRV = true;
+            hazard.m_boundAsRenderTarget = true;
+
+            // Some apps want to be able to read from the currently bound render target.
+            // Examples include Tree of Savior
+            D3D12TranslationLayer::TDeclVector* pDecls = nullptr;
+            if (shaderStage == D3D12TranslationLayer::e_PS && m_pCurrentD3D12PixelShader)
+            {
+                pDecls = &m_pCurrentD3D12PixelShader->GetUnderlying()->m_ResourceDecls;
+            }
+            else if (shaderStage == D3D12TranslationLayer::e_VS)
+            {
+                auto pVS = device.GetPipelineState().GetVertexStage().GetCurrentD3D12VertexShader();
+                if (pVS)
+                {
+                    pDecls = &pVS->GetUnderlying()->m_ResourceDecls;
+                }
+            }
+            if (pDecls)
+            {
+                if (shaderRegister < pDecls->size() && (*pDecls)[shaderRegister] != D3D12TranslationLayer::RESOURCE_DIMENSION::UNKNOWN)
+                {
+                    hazard.m_sampleBackingCopy = true;
+                    HideSRV = false;
+                }
+            }
         }
+
+        hazard.m_hideSRV = HideSRV;
+        hazard.m_pResource = pResource;
+        // Read after the INTZ fix, which changes ZWriteEnable and so starts a new generation
+        hazard.m_generation = m_outputBindingGeneration;
+    }
+
+    void PixelStage::BindShaderResourceRanges(Device& device, D3D12TranslationLayer::SRV* const (&pSRVs)[MAX_SAMPLERS_STAGES], UINT changedMask)
+    {
+        auto& context = device.GetContext();
+
+        ForEachShaderResourceRun(changedMask, [&](UINT first, UINT count)
+        {
+            DWORD shaderRegister;
+            D3D12TranslationLayer::EShaderStage shaderStage;
+            ConvertDX9TextureIndexToShaderStageAndRegisterIndex(first, shaderStage, shaderRegister);
+
+            if (shaderStage == D3D12TranslationLayer::e_PS)
+            {
+                context.SetShaderResources<D3D12TranslationLayer::e_PS>(shaderRegister, count, &pSRVs[first]);
+            }
+            else
+            {
+                context.SetShaderResources<D3D12TranslationLayer::e_VS>(shaderRegister, count, &pSRVs[first]);
+            }
+        });
     }
 
 
@@ -223,16 +317,17 @@ namespace D3D9on12
             if (m_pDepthStencil)
             {
                 m_pDepthStencil->GetDSVBindingTracker().Unbind(0);
-                MarkSRVIndicesDirty(m_pDepthStencil->GetSRVBindingTracker().GetBindingIndices());
+                MarkSRVIndicesDirty(m_pDepthStencil->GetSRVBindingTracker().GetBindingMask());
             }
 
             if (pDepthStencil)
             {
                 pDepthStencil->GetDSVBindingTracker().Bind(0);
-                MarkSRVIndicesDirty(pDepthStencil->GetSRVBindingTracker().GetBindingIndices());
+                MarkSRVIndicesDirty(pDepthStencil->GetSRVBindingTracker().GetBindingMask());
             }
 
             m_pDepthStencil = pDepthStencil;
+            ++m_outputBindingGeneration;
             m_dirtyFlags.DepthStencil = true;
             m_dirtyFlags.RenderTargets = true;
         }
@@ -272,13 +367,14 @@ namespace D3D9on12
             if (pPrevResource)
             {
                 pPrevResource->GetRTVBindingTracker().Unbind(renderTargetIndex);
-                MarkSRVIndicesDirty(pPrevResource->GetSRVBindingTracker().GetBindingIndices());
+                MarkSRVIndicesDirty(pPrevResource->GetSRVBindingTracker().GetBindingMask());
             }
+            ++m_outputBindingGeneration;
 
             if (pNewResource)
             {
                 pNewResource->GetRTVBindingTracker().Bind(renderTargetIndex);
-                MarkSRVIndicesDirty(pNewResource->GetSRVBindingTracker().GetBindingIndices());
+                MarkSRVIndicesDirty(pNewResource->GetSRVBindingTracker().GetBindingMask());
 
                 bool bDisableAlpha = pNewResource->IsAlphaChannelDisabled();
                 UINT rtvShaderComponentMapping = ConvertFormatToShaderResourceViewComponentMapping(pNewResource->GetD3DFormat());
@@ -368,6 +464,11 @@ namespace D3D9on12
             break;
         case D3DRS_ZWRITEENABLE:
         {
+            if (m_depthStencilStateID.ZWriteEnable != (dwValue & 1))
+            {
+                // Decides whether a depth stencil sampled while bound is hidden
+                ++m_outputBindingGeneration;
+            }
             m_depthStencilStateID.ZWriteEnable = dwValue;
             D3D12_DSV_FLAGS oldState = m_dsvRWType;
             if (m_depthStencilStateID.ZWriteEnable)
@@ -385,7 +486,7 @@ namespace D3D9on12
                 // Hide or unhide the SRVs of the current depth stencil as appropriate
                 if (m_pDepthStencil)
                 {
-                    MarkSRVIndicesDirty(m_pDepthStencil->GetSRVBindingTracker().GetBindingIndices());
+                    MarkSRVIndicesDirty(m_pDepthStencil->GetSRVBindingTracker().GetBindingMask());
                 }
             }
 
@@ -419,6 +520,7 @@ namespace D3D9on12
         case D3DRS_STENCILREF:
             m_depthStencilStateID.StencilRef = static_cast<UINT8>(dwValue);
             m_dirtyFlags.DepthStencilState = true;
+            device.FlushPendingDraw();
             context.OMSetStencilRef(m_depthStencilStateID.StencilRef);
             break;
         case D3DRS_STENCILMASK:
@@ -501,6 +603,7 @@ namespace D3D9on12
             m_dirtyFlags.BlendState = true;
             {
                 DirectX::XMFLOAT4 factor = ARGBToUNORMFloat(m_blendFactor);
+                device.FlushPendingDraw();
                 context.OMSetBlendFactor((float*)&factor);
             }
             break;
@@ -788,7 +891,7 @@ namespace D3D9on12
                     DWORD shaderRegister;
                     D3D12TranslationLayer::EShaderStage shaderStage;
 
-                    D3D12TranslationLayer::Sampler* sampler = m_samplerCache.GetSampler(device, m_samplerStateIDs[i]);
+                    D3D12TranslationLayer::Sampler* sampler = m_samplerCache.GetSampler(device, m_samplerStateIDs[i], i);
                     ConvertDX9TextureIndexToShaderStageAndRegisterIndex(i, shaderStage, shaderRegister);
 
                     if (shaderStage == D3D12TranslationLayer::e_PS)
@@ -883,90 +986,79 @@ namespace D3D9on12
         textureDirtyMaskToKeep = 0;
         if (m_dirtyFlags.Textures)
         {
-            UINT textureMask = m_dirtyFlags.Textures;
-            for (UINT i = 0; textureMask > 0; textureMask = textureMask >> 1, ++i)
+            // Only slots whose view actually changed are sent to the context, in runs of consecutive registers
+            D3D12TranslationLayer::SRV* pChangedSRVs[MAX_SAMPLERS_STAGES] = {};
+            UINT changedMask = 0;
+
+            // Render targets read through a backing copy can't change until the draw, so copy each one at most once
+            ++m_textureResolveGeneration;
+
+            // Whether a slot that samples a bound render target can read a backing copy depends on the shader declarations
+            const void* pPSDecls = m_pCurrentD3D12PixelShader ? &m_pCurrentD3D12PixelShader->GetUnderlying()->m_ResourceDecls : nullptr;
+            auto pCurrentVS = device.GetPipelineState().GetVertexStage().GetCurrentD3D12VertexShader();
+            const void* pVSDecls = pCurrentVS ? &pCurrentVS->GetUnderlying()->m_ResourceDecls : nullptr;
+            if (pPSDecls != m_pHazardCheckedPSDecls || pVSDecls != m_pHazardCheckedVSDecls)
             {
-                if (textureMask & BIT(0))
-                {
-                    DWORD shaderRegister;
-                    D3D12TranslationLayer::EShaderStage shaderStage;
-                    ConvertDX9TextureIndexToShaderStageAndRegisterIndex(i, shaderStage, shaderRegister);
-
-                    D3D12TranslationLayer::SRV* pSRV = nullptr;
-                    Resource* pResource = m_shaderResources[i];
-                    if (pResource)
-                    {   
-                        // Certain apps expect the driver to automatically unbind resources as SRVs when they are bound as RTVs
-                        // Examples inclue Alan Wake and Valkyrie Chronicles
-                        bool HideSRV = pResource->GetDSVBindingTracker().IsBound() && GetDepthStencilStateID().ZWriteEnable;
-
-                        // resources with INTZ surface format, set ZWriteEnable to false instead of hiding SRV
-                        if (!g_AppCompatInfo.DisableIntzDSVFix && HideSRV && (pResource->GetD3DFormat() == D3DFMT_INTZ))
-                        {
-                            HideSRV = false;
-                            SetDepthStencilState(device, D3DRS_ZWRITEENABLE, 0);
-                            device.GetPipelineState().SetIntzRestoreZWrite(true);
-                        }
+                m_pHazardCheckedPSDecls = pPSDecls;
+                m_pHazardCheckedVSDecls = pVSDecls;
+                ++m_outputBindingGeneration;
+            }
 
-                        if (!HideSRV && pResource->GetRTVBindingTracker().IsBound())
-                        {
-                            HideSRV = true;
-
-                            // Some apps want to be able to read from the currently bound render target.
-                            // Examples include Tree of Savior
-                            D3D12TranslationLayer::TDeclVector* pDecls = nullptr;
-                            if (shaderStage == D3D12TranslationLayer::e_PS && m_pCurrentD3D12PixelShader)
-                            {
-                                pDecls = &m_pCurrentD3D12PixelShader->GetUnderlying()->m_ResourceDecls;
-                            }
-                            else if (shaderStage == D3D12TranslationLayer::e_VS)
-                            {
-                                auto pVS = device.GetPipelineState().GetVertexStage().GetCurrentD3D12VertexShader();
-                                if (pVS)
-                                {
-                                    pDecls = &pVS->GetUnderlying()->m_ResourceDecls;
-                                }
-                            }
-                            if (pDecls)
-                            {
-                                if (shaderRegister < pDecls->size() && (*pDecls)[shaderRegister] != D3D12TranslationLayer::RESOURCE_DIMENSION::UNKNOWN)
-                                {
-                                    pResource = pResource->GetBackingPlainResource();
-                                    HideSRV = false;
-                                }
-                            }
-                            textureDirtyMaskToKeep |= BIT(i); // Set this dirty bit again to check if we should do this copy next time
-                        }
+            UINT textureMask = m_dirtyFlags.Textures;
+            DWORD i;
+            while (BitScanForward(&i, textureMask))
+            {
+                textureMask &= textureMask - 1;
+
+                D3D12TranslationLayer::SRV* pSRV = nullptr;
+                Resource* pResource = m_shaderResources[i];
+                if (pResource)
+                {   
+                    SRVHazardState &hazard = m_srvHazardStates[i];
+                    if (hazard.m_pResource != pResource || hazard.m_generation != m_outputBindingGeneration)
+                    {
+                        CheckSRVHazard(device, i, pResource, hazard);
+                    }
 
-                        if (HideSRV)
-                        {
-                            pSRV = nullptr;
-                        }
-                        else
-                        {
-                            DWORD flags = Resource::ShaderResourceViewFlags::None;
-                            if (GetSamplerID(i).MipFilter == D3DDDITEXF_NONE)
-                            {
-                                flags |= Resource::ShaderResourceViewFlags::DisableMips;
-                            }
-                            if (m_SRGBTexture[i])
-                            {
-                                flags |= Resource::ShaderResourceViewFlags::SRGBEnabled;
-                            }
-                            pSRV = pResource->GetShaderResourceView(flags);
-                        }
+                    const bool HideSRV = hazard.m_hideSRV;
+                    if (hazard.m_sampleBackingCopy)
+                    {
+                        pResource = pResource->GetBackingPlainResourceForGeneration(m_textureResolveGeneration);
+                    }
+                    if (hazard.m_boundAsRenderTarget)
+                    {
+                        textureDirtyMaskToKeep |= BIT(i); // Set this dirty bit again to check if we should do this copy next time
                     }
 
-                    if (shaderStage == D3D12TranslationLayer::e_PS)
+                    if (HideSRV)
                     {
-                        context.SetShaderResources<D3D12TranslationLayer::e_PS>(shaderRegister, 1, &pSRV);
+                        pSRV = nullptr;
                     }
                     else
                     {
-                        context.SetShaderResources<D3D12TranslationLayer::e_VS>(shaderRegister, 1, &pSRV);
+                        DWORD flags = Resource::ShaderResourceViewFlags::None;
+                        if (GetSamplerID(i).MipFilter == D3DDDITEXF_NONE)
+                        {
+                            flags |= Resource::ShaderResourceViewFlags::DisableMips;
+                        }
+                        if (m_SRGBTexture[i])
+                        {
+                            flags |= Resource::ShaderResourceViewFlags::SRGBEnabled;
+                        }
+                        pSRV = pResource->GetShaderResourceView(flags);
                     }
                 }
+
+                if (pSRV != m_pBoundSRVs[i])
+                {
+                    m_pBoundSRVs[i] = pSRV;
+                    m_pBoundSRVResources[i] = pSRV ? pResource : nullptr;
+                    pChangedSRVs[i] = pSRV;
+                    changedMask |= BIT(i);
+                }
             }
+
+            BindShaderResourceRanges(device, pChangedSRVs, changedMask);
         }
 
         if (m_dirtyFlags.DepthStencilState)
@@ -1001,20 +1093,55 @@ namespace D3D9on12
         return hr;
     }
 
-    D3D12TranslationLayer::Sampler* PixelStage::SamplerCache::GetSampler(Device& device, SamplerStateID& id)
+    D3D12TranslationLayer::Sampler* PixelStage::SamplerCache::GetSampler(Device& device, SamplerStateID& stateID, UINT stage)
     {
+        const SamplerStateID id = CanonicalizeSamplerStateID(stateID);
+
+        D3D12TranslationLayer::Sampler* pSampler = nullptr;
         auto result = m_map.find(id);
         if (result == m_map.end())
         {
+            if (m_map.size() >= max(size_t(RegistryConstants::g_cMaxCachedSamplers), size_t(cMinCachedSamplers)))
+            {
+                EvictLeastRecentlyUsed();
+            }
+
             D3D12_SAMPLER_DESC createSamplerDesc = ConvertSampler(id, device.m_Options19.AnisoFilterWithPointMipSupported);
 
-            m_map[id] = std::unique_ptr<D3D12TranslationLayer::Sampler>(new D3D12TranslationLayer::Sampler(&device.GetContext(), createSamplerDesc));
+            std::unique_ptr<D3D12TranslationLayer::Sampler> pNewSampler(new D3D12TranslationLayer::Sampler(&device.GetContext(), createSamplerDesc));
+            m_lru.push_back(id);
 
-            return m_map[id].get();
+            CacheEntry& entry = m_map[id];
+            entry.m_pSampler = std::move(pNewSampler);
+            entry.m_lruPosition = std::prev(m_lru.end());
+            pSampler = entry.m_pSampler.get();
         }
         else
         {
-            return result->second.get();
+            m_lru.splice(m_lru.end(), m_lru, result->second.m_lruPosition);
+            pSampler = result->second.m_pSampler.get();
+        }
+
+        m_pBoundSamplers[stage] = pSampler;
+        return pSampler;
+    }
+
+    void PixelStage::SamplerCache::EvictLeastRecentlyUsed()
+    {
+        for (auto it = m_lru.begin(); it != m_lru.end(); ++it)
+        {
+            auto entry = m_map.find(*it);
+            Check9on12(entry != m_map.end());
+
+            // The stage being resolved still counts as bound to its old sampler, so the new one can't reuse its address
+            // and be mistaken for it
+            const D3D12TranslationLayer::Sampler* pSampler = entry->second.m_pSampler.get();
+            if (std::find(std::begin(m_pBoundSamplers), std::end(m_pBoundSamplers), pSampler) == std::end(m_pBoundSamplers))
+            {
+                m_map.erase(entry);
+                m_lru.erase(it);
+                return;
+            }
         }
     }
 
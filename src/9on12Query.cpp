@@ -4,27 +4,112 @@
 
 namespace D3D9on12
 {
-    _Check_return_ HRESULT APIENTRY CheckCounter(_In_ HANDLE hDevice, _In_ D3DDDIQUERYTYPE, _Out_ D3DDDI_COUNTER_TYPE*, _Out_ UINT*,
-        _Out_writes_to_opt_(*pNameLength, *pNameLength) LPSTR,
+    struct DeviceCounterInfo
+    {
+        LPCSTR m_name;
+        LPCSTR m_units;
+        LPCSTR m_description;
+    };
+
+    // Indexed by DeviceStatistics::DeviceCounter, counter n is exposed as D3DDDIQUERYTYPE_COUNTER_DEVICE_DEPENDENT + n
+    static const DeviceCounterInfo g_cDeviceCounterInfo[] =
+    {
+        { "D3D9on12 shader conversions", "Conversions", "D3D9 shaders converted to DXBC, including derived variants" },
+        { "D3D9on12 PSO compilations", "Compilations", "Pipeline state objects created because of a pipeline state cache miss" },
+        { "D3D9on12 upload heap bytes", "Bytes", "Bytes allocated from the upload heaps for dynamic data such as UP draws and constants" },
+        { "D3D9on12 lock stall time", "Microseconds", "Time spent in Lock calls that were allowed to wait for the GPU" },
+        { "D3D9on12 readback waits", "Waits", "GPU to CPU copies the driver had to wait on before returning" },
+        { "D3D9on12 flushes", "Flushes", "Command list submissions requested by the driver or the application" },
+        { "D3D9on12 shader cache hits", "Hits", "Draws that found the D3D9 shader variant they needed already converted" },
+        { "D3D9on12 PSO cache hits", "Hits", "Draws that found their pipeline state object in the pipeline state cache" },
+        { "D3D9on12 draw resolve time", "Microseconds", "CPU time spent turning the D3D9 state into D3D12 state before draws" },
+        { "D3D9on12 present time", "Microseconds", "CPU time spent in Present, including the flush it submits" },
+        { "D3D9on12 DDI calls", "Calls", "DDI calls made by the runtime on any device in the process, summed over all entry points" },
+    };
+    static_assert(_countof(g_cDeviceCounterInfo) == DeviceStatistics::NumDeviceCounters, "Every device counter needs a description");
+
+    static bool IsDeviceDependentCounter(D3DDDIQUERYTYPE queryType)
+    {
+        return queryType >= D3DDDIQUERYTYPE_COUNTER_DEVICE_DEPENDENT &&
+            queryType < D3DDDIQUERYTYPE_COUNTER_DEVICE_DEPENDENT + DeviceStatistics::NumDeviceCounters;
+    }
+
+    static DeviceStatistics::DeviceCounter GetDeviceCounter(D3DDDIQUERYTYPE queryType)
+    {
+        Check9on12(IsDeviceDependentCounter(queryType));
+        return DeviceStatistics::DeviceCounter(queryType - D3DDDIQUERYTYPE_COUNTER_DEVICE_DEPENDENT);
+    }
+
+    // Reports the length needed including the terminator and copies the string if the caller passed a buffer
+    static HRESULT CopyCounterString(LPCSTR pSource, _Out_writes_to_opt_(*pLength, *pLength) LPSTR pDest, _Inout_opt_ UINT* pLength)
+    {
+        if (pLength == nullptr)
+        {
+            return S_OK;
+        }
+
+        const UINT requiredLength = UINT(strlen(pSource) + 1);
+        if (pDest != nullptr)
+        {
+            if (*pLength < requiredLength)
+            {
+                return E_INVALIDARG;
+            }
+            strcpy_s(pDest, *pLength, pSource);
+        }
+        *pLength = requiredLength;
+        return S_OK;
+    }
+
+    _Check_return_ HRESULT APIENTRY CheckCounter(_In_ HANDLE hDevice, _In_ D3DDDIQUERYTYPE counterType, _Out_ D3DDDI_COUNTER_TYPE* pCounterType, _Out_ UINT* pActiveCounters,
+        _Out_writes_to_opt_(*pNameLength, *pNameLength) LPSTR pName,
         _Inout_opt_ UINT* pNameLength,
-        _Out_writes_to_opt_(*pUnitsLength, *pUnitsLength) LPSTR,
+        _Out_writes_to_opt_(*pUnitsLength, *pUnitsLength) LPSTR pUnits,
         _Inout_opt_ UINT* pUnitsLength,
-        _Out_writes_to_opt_(*pDescriptionLength, *pDescriptionLength) LPSTR,
+        _Out_writes_to_opt_(*pDescriptionLength, *pDescriptionLength) LPSTR pDescription,
         _Inout_opt_ UINT* pDescriptionLength)
     {
-        UNREFERENCED_PARAMETER(hDevice);
-        UNREFERENCED_PARAMETER(pNameLength);
-        UNREFERENCED_PARAMETER(pUnitsLength);
-        UNREFERENCED_PARAMETER(pDescriptionLength);
-
         D3D9on12_DDI_ENTRYPOINT_START(TRUE);
-        D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(S_OK);
+        Device* pDevice = Device::GetDeviceFromHandle(hDevice);
+        if (pDevice == nullptr || pCounterType == nullptr || pActiveCounters == nullptr || !IsDeviceDependentCounter(counterType))
+        {
+            RETURN_E_INVALIDARG_AND_CHECK();
+        }
+
+        const DeviceCounterInfo& info = g_cDeviceCounterInfo[GetDeviceCounter(counterType)];
+
+        // Every counter is a CPU side tally, so all of them can be active at once
+        *pCounterType = D3DDDI_COUNTER_TYPE_UINT64;
+        *pActiveCounters = 1;
+
+        HRESULT hr = CopyCounterString(info.m_name, pName, pNameLength);
+        if (SUCCEEDED(hr))
+        {
+            hr = CopyCounterString(info.m_units, pUnits, pUnitsLength);
+        }
+        if (SUCCEEDED(hr))
+        {
+            hr = CopyCounterString(info.m_description, pDescription, pDescriptionLength);
+        }
+
+        D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(hr);
     }
 
-    VOID APIENTRY CheckCounterInfo(_In_ HANDLE hDevice, _Out_ D3DDDIARG_COUNTER_INFO* /*pCounterInfo*/)
+    VOID APIENTRY CheckCounterInfo(_In_ HANDLE hDevice, _Out_ D3DDDIARG_COUNTER_INFO* pCounterInfo)
     {
         D3D9on12_DDI_ENTRYPOINT_START(TRUE);
-        D3D9on12_DDI_ENTRYPOINT_END_AND_REPORT_HR(hDevice, S_OK);
+        HRESULT hr = S_OK;
+        if (pCounterInfo == nullptr)
+        {
+            hr = E_INVALIDARG;
+        }
+        else
+        {
+            pCounterInfo->LastDeviceDependentCounter = D3DDDIQUERYTYPE(D3DDDIQUERYTYPE_COUNTER_DEVICE_DEPENDENT + DeviceStatistics::NumDeviceCounters - 1);
+            pCounterInfo->NumSimultaneousCounters = DeviceStatistics::NumDeviceCounters;
+            pCounterInfo->NumDetectableParallelUnits = 1;
+        }
+        D3D9on12_DDI_ENTRYPOINT_END_AND_REPORT_HR(hDevice, hr);
     }
 
     _Check_return_ HRESULT APIENTRY SetMarker(_In_ HANDLE /*hDevice*/)
@@ -98,6 +183,7 @@ namespace D3D9on12
             RETURN_E_INVALIDARG_AND_CHECK();
         }
 
+        pDevice->FlushPendingDraw();
         HRESULT hr = pQuery->Issue(*pDevice, pIssueQuery->Flags);
 
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(hr);
@@ -125,14 +211,29 @@ namespace D3D9on12
     Query::Query(D3DDDIQUERYTYPE queryType) : 
         m_type(queryType),
         m_eventFenceValue(m_cUnitializedFenceValue),
-        m_pUnderlyingQuery(nullptr)
+        m_pUnderlyingQuery(nullptr),
+        m_pActiveLogger(nullptr)
     {};
 
+    Query::~Query()
+    {
+        if (m_pActiveLogger)
+        {
+            m_pActiveLogger->EndCounterQuery();
+        }
+    }
+
 
     HRESULT Query::Init(Device& device)
     {
         HRESULT hr = S_OK;
 
+        if (m_type >= D3DDDIQUERYTYPE_COUNTER_DEVICE_DEPENDENT)
+        {
+            // Counters don't need an underlying query, they're snapshots of the DataLogger
+            return IsDeviceDependentCounter(m_type) ? S_OK : E_INVALIDARG;
+        }
+
         switch (m_type)
         {
         case D3DDDIQUERYTYPE_EVENT:
@@ -160,10 +261,49 @@ namespace D3D9on12
         return hr;
     }
 
-    HRESULT Query::Issue(Device& /*device*/, D3DDDI_ISSUEQUERYFLAGS flags)
+    HRESULT Query::IssueStatistics(Device& device, D3DDDI_ISSUEQUERYFLAGS flags)
+    {
+        DataLogger& logger = device.GetDataLogger();
+        const bool isCounter = IsDeviceDependentCounter(m_type);
+        if (flags.Begin)
+        {
+            if (isCounter && m_pActiveLogger == nullptr)
+            {
+                logger.BeginCounterQuery();
+                m_pActiveLogger = &logger;
+            }
+            m_beginStatistics = logger.GetStatistics();
+        }
+        else if (flags.End)
+        {
+            m_endStatistics = logger.GetStatistics();
+            if (m_pActiveLogger)
+            {
+                m_pActiveLogger->EndCounterQuery();
+                m_pActiveLogger = nullptr;
+            }
+            else
+            {
+                // An End without a Begin covers an empty interval
+                m_beginStatistics = m_endStatistics;
+            }
+        }
+        else
+        {
+            Check9on12(false);
+        }
+        return S_OK;
+    }
+
+    HRESULT Query::Issue(Device& device, D3DDDI_ISSUEQUERYFLAGS flags)
     {
         HRESULT hr = S_OK;
 
+        if (IsDeviceDependentCounter(m_type))
+        {
+            return IssueStatistics(device, flags);
+        }
+
         switch (m_type)
         {
         case D3DDDIQUERYTYPE_EVENT:
@@ -172,6 +312,7 @@ namespace D3D9on12
         case D3DDDIQUERYTYPE_TIMESTAMPDISJOINT:
         case D3DDDIQUERYTYPE_TIMESTAMPFREQ:
         {
+            m_resultCache.Reset();
             if (flags.Begin)
             {
                 m_pUnderlyingQuery->Begin();
@@ -191,6 +332,8 @@ namespace D3D9on12
 
         case D3DDDIQUERYTYPE_RESOURCEMANAGER:
         case D3DDDIQUERYTYPE_VERTEXSTATS:
+            return IssueStatistics(device, flags);
+
         case D3DDDIQUERYTYPE_DDISTATS:
         case D3DDDIQUERYTYPE_PIPELINETIMINGS:
         case D3DDDIQUERYTYPE_INTERFACETIMINGS:
@@ -198,7 +341,6 @@ namespace D3D9on12
         case D3DDDIQUERYTYPE_PIXELTIMINGS:
         case D3DDDIQUERYTYPE_BANDWIDTHTIMINGS:
         case D3DDDIQUERYTYPE_CACHEUTILIZATION:
-        case D3DDDIQUERYTYPE_COUNTER_DEVICE_DEPENDENT:
         default:
             Check9on12(false);
             hr = E_NOTIMPL;
@@ -207,17 +349,82 @@ namespace D3D9on12
         return hr;
     }
 
-    HRESULT Query::GetData(Device& /*device*/, VOID* pData)
+    static DWORD ClampToDWORD(UINT64 value)
+    {
+        return DWORD(min(value, UINT64(MAXDWORD)));
+    }
+
+    void Query::FillStatisticsData(VOID* pData)
+    {
+        if (IsDeviceDependentCounter(m_type))
+        {
+            const DeviceStatistics::DeviceCounter counter = GetDeviceCounter(m_type);
+            *reinterpret_cast<UINT64*>(pData) = m_endStatistics.m_counters[counter] - m_beginStatistics.m_counters[counter];
+            return;
+        }
+
+        switch (m_type)
+        {
+        case D3DDDIQUERYTYPE_VERTEXSTATS:
+        {
+            D3DDEVINFO_D3DVERTEXSTATS& vertexStats = *reinterpret_cast<D3DDEVINFO_D3DVERTEXSTATS*>(pData);
+            vertexStats.NumRenderedTriangles = ClampToDWORD(m_endStatistics.m_renderedTrianglesSincePresent);
+            vertexStats.NumExtraClippingTriangles = 0; // Clipping happens on the GPU and isn't visible here
+            break;
+        }
+        case D3DDDIQUERYTYPE_RESOURCEMANAGER:
+        {
+            // Every resource created through the driver is reported as managed, eviction is left to the OS so the
+            // eviction and thrashing fields stay 0
+            D3DDEVINFO_RESOURCEMANAGER& resourceManager = *reinterpret_cast<D3DDEVINFO_RESOURCEMANAGER*>(pData);
+            memset(&resourceManager, 0, sizeof(resourceManager));
+            for (UINT type = 0; type < D3DRTYPECOUNT; type++)
+            {
+                const DeviceStatistics::ResourceTypeStatistics& source = m_endStatistics.m_resources[type];
+                D3DRESOURCESTATS& stats = resourceManager.stats[type];
+                stats.ApproxBytesDownloaded = ClampToDWORD(source.m_bytesUploadedSincePresent);
+                stats.NumVidCreates = ClampToDWORD(source.m_videoMemoryCreatesSincePresent);
+                stats.WorkingSet = ClampToDWORD(source.m_videoMemoryCount);
+                stats.WorkingSetBytes = ClampToDWORD(source.m_videoMemoryBytes);
+                stats.TotalManaged = ClampToDWORD(source.m_liveCount);
+                stats.TotalBytes = ClampToDWORD(source.m_liveBytes);
+            }
+            break;
+        }
+        default:
+            Check9on12(false);
+            break;
+        }
+    }
+
+    bool Query::PollUnderlyingQuery(_Out_writes_bytes_(dataSize) void* pData, UINT dataSize)
+    {
+        return m_resultCache.GetResult(pData, dataSize, [this](void* pResult, UINT resultSize)
+        {
+            // Polling never flushes, D3DGETDATA_FLUSH is turned into a separate Flush DDI call by the runtime
+            // so apps that spin on hundreds of queries a frame don't fragment the command list
+            const bool doNotFlush = true;
+            return m_pUnderlyingQuery->GetData(pResult, resultSize, doNotFlush, false);
+        });
+    }
+
+    HRESULT Query::GetData(Device& device, VOID* pData)
     {
         HRESULT hr = S_FALSE;
 
+        if (IsDeviceDependentCounter(m_type))
+        {
+            FillStatisticsData(pData);
+            return S_OK;
+        }
+
         switch (m_type)
         {
         case D3DDDIQUERYTYPE_EVENT:
         {
             BOOL finished = false;
 
-            if (m_pUnderlyingQuery->GetData(&finished, sizeof(finished), true, false))
+            if (PollUnderlyingQuery(&finished, sizeof(finished)))
             {
                 *reinterpret_cast<BOOL*>(pData) = finished;
                 return S_OK;
@@ -230,7 +437,7 @@ namespace D3D9on12
         case D3DDDIQUERYTYPE_OCCLUSION:
         {
             UINT64 occluded = 0;
-            if (m_pUnderlyingQuery->GetData(&occluded, sizeof(occluded), true, false))
+            if (PollUnderlyingQuery(&occluded, sizeof(occluded)))
             {
                 *reinterpret_cast<DWORD*>(pData) = DWORD(occluded);
                 return S_OK;
@@ -243,7 +450,7 @@ namespace D3D9on12
         case D3DDDIQUERYTYPE_TIMESTAMP:
         {
             UINT64 timestamp = 0;
-            if (m_pUnderlyingQuery->GetData(&timestamp, sizeof(timestamp), true, false))
+            if (PollUnderlyingQuery(&timestamp, sizeof(timestamp)))
             {
                 *reinterpret_cast<DWORD*>(pData) = DWORD(timestamp);
                 return S_OK;
@@ -257,7 +464,7 @@ namespace D3D9on12
         case D3DDDIQUERYTYPE_TIMESTAMPDISJOINT:
         {
             D3D12TranslationLayer::QUERY_DATA_TIMESTAMP_DISJOINT disjointResult = {};
-            if (m_pUnderlyingQuery->GetData(&disjointResult, sizeof(disjointResult), true, false))
+            if (PollUnderlyingQuery(&disjointResult, sizeof(disjointResult)))
             {
                 BOOL isDisjoint = disjointResult.Disjoint;
                 if (m_type == D3DDDIQUERYTYPE_TIMESTAMPDISJOINT)
@@ -279,16 +486,24 @@ namespace D3D9on12
         }
         case D3DDDIQUERYTYPE_VCACHE:
         {
+            const UINT cacheSize = device.GetAdapter().GetPostTransformVertexCacheSize();
+
             D3DDEVINFO_VCACHE Data;
             Data.Pattern = MAKEFOURCC('C', 'A', 'C', 'H');
-            Data.OptMethod = 0;
-            Data.CacheSize = 0;
-            Data.MagicNumber = 0;
+            Data.OptMethod = 1; // Optimize for the vertex cache rather than longest strips
+            Data.CacheSize = cacheSize;
+            // D3DX's vertex cache optimizer builds strips and uses MagicNumber as its strip restart trial value. It must
+            // be in [1, CacheSize] and is documented to work best near CacheSize / 2.
+            Data.MagicNumber = max(cacheSize / 2, 1u);
             *reinterpret_cast<D3DDEVINFO_VCACHE*>(pData) = Data;
             return S_OK;
         }
         case D3DDDIQUERYTYPE_RESOURCEMANAGER:
         case D3DDDIQUERYTYPE_VERTEXSTATS:
+        {
+            FillStatisticsData(pData);
+            return S_OK;
+        }
         case D3DDDIQUERYTYPE_DDISTATS:
         case D3DDDIQUERYTYPE_PIPELINETIMINGS:
         case D3DDDIQUERYTYPE_INTERFACETIMINGS:
@@ -296,7 +511,6 @@ namespace D3D9on12
         case D3DDDIQUERYTYPE_PIXELTIMINGS:
         case D3DDDIQUERYTYPE_BANDWIDTHTIMINGS:
         case D3DDDIQUERYTYPE_CACHEUTILIZATION:
-        case D3DDDIQUERYTYPE_COUNTER_DEVICE_DEPENDENT:
         default:
             Check9on12(false);
             hr = E_NOTIMPL;
@@ -253,6 +253,7 @@ namespace D3D9on12
         }
 
         Check9on12(pDepthFill->SubResourceIndex == 0);
+        pDevice->FlushPendingDraw();
         HRESULT hr =pResource->ClearDepthStencil(D3DCLEAR_ZBUFFER, &pDepthFill->DstRect, 1, (float)pDepthFill->Depth, 0);
         CHECK_HR(hr);
 
@@ -349,6 +350,7 @@ namespace D3D9on12
         }
 
         HRESULT hr = S_OK;
+        pDevice->FlushPendingDraw();
         delete pResource;
         
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(hr);
@@ -382,6 +384,7 @@ namespace D3D9on12
         UINT numPlanes;
         pResource->ConvertAppSubresourceToDX12SubresourceIndices(pColorFill->SubResourceIndex, subresourceIndices, numPlanes);
 
+        pDevice->FlushPendingDraw();
         if (numPlanes == 1)
         {
             pResource->Clear(subresourceIndices[0], &pColorFill->DstRect, 1, pColorFill->Color);
@@ -408,6 +411,7 @@ namespace D3D9on12
             RETURN_E_INVALIDARG_AND_CHECK();
         }
 
+        pDevice->FlushPendingDraw();
         if (pClearArg->Flags & D3DCLEAR_TARGET)
         {
             for (UINT i = 0; i < MAX_RENDER_TARGETS; i++)
@@ -465,6 +469,7 @@ namespace D3D9on12
         pResource->ConvertAppSubresourceToDX12SubresourceIndices(pLockArg->SubResourceIndex, subresourceIndicies, numPlanes);
         Check9on12(numPlanes > 0);
 
+        pDevice->FlushPendingDraw();
         HRESULT hr = S_OK;
         for (UINT planeIndex = 0; planeIndex < numPlanes && SUCCEEDED(hr); planeIndex++)
         {
@@ -512,6 +517,7 @@ namespace D3D9on12
         UINT subresourceIndicies[MAX_PLANES];
         UINT numPlanes = 0;
         pResource->ConvertAppSubresourceToDX12SubresourceIndices(pUnlockArg->SubResourceIndex, subresourceIndicies, numPlanes);
+        pDevice->FlushPendingDraw();
         for (UINT planeIndex = 0; planeIndex < numPlanes; planeIndex++)
         {
             pResource->Unlock(*pDevice, subresourceIndicies[planeIndex], pUnlockArg->Flags, false);
@@ -532,6 +538,7 @@ namespace D3D9on12
         HRESULT hr = S_OK;
         if (pResource != nullptr)
         {
+            pDevice->FlushPendingDraw();
             hr = pResource->GenerateMips(pArgs->Filter);
         }
         else
@@ -649,37 +656,38 @@ namespace D3D9on12
         // This must be called before the views are destroyed
         m_pParentDevice->GetContext().ClearInputBindings(m_pResource.get());
         m_pParentDevice->GetContext().ClearOutputBindings(m_pResource.get());
+        m_pParentDevice->GetPipelineState().GetPixelStage().ClearBoundShaderResourceViews(this);
 
-        while (GetSRVBindingTracker().GetBindingIndices().size())
+        while (GetSRVBindingTracker().IsBound())
         {
-            ThrowFailure(m_pParentDevice->GetPipelineState().GetPixelStage().SetSRV(*m_pParentDevice, nullptr, GetSRVBindingTracker().GetBindingIndices()[0]));
+            ThrowFailure(m_pParentDevice->GetPipelineState().GetPixelStage().SetSRV(*m_pParentDevice, nullptr, GetSRVBindingTracker().GetFirstBindingIndex()));
         }
 
         const BoundRenderTarget nullRenderTarget(nullptr, 0);
-        while (GetRTVBindingTracker().GetBindingIndices().size())
+        while (GetRTVBindingTracker().IsBound())
         {
-            m_pParentDevice->GetPipelineState().GetPixelStage().SetRenderTarget(GetRTVBindingTracker().GetBindingIndices()[0], nullRenderTarget);
+            m_pParentDevice->GetPipelineState().GetPixelStage().SetRenderTarget(GetRTVBindingTracker().GetFirstBindingIndex(), nullRenderTarget);
         }
 
-        while (GetVBBindingTracker().GetBindingIndices().size())
+        while (GetVBBindingTracker().IsBound())
         {
             m_pParentDevice->GetPipelineState().GetInputAssembly().SetVertexBuffer(
                 *m_pParentDevice, 
                 nullptr, 
-                GetVBBindingTracker().GetBindingIndices()[0], 
+                GetVBBindingTracker().GetFirstBindingIndex(), 
                 0, 
                 0);
         }
 
         if (GetDSVBindingTracker().IsBound())
         {
-            assert(GetDSVBindingTracker().GetBindingIndices().size() == 1);
+            assert(GetDSVBindingTracker().GetBindingCount() == 1);
             m_pParentDevice->GetPipelineState().GetPixelStage().SetDepthStencil(nullptr);
         }
 
         if (GetIBBindingTracker().IsBound())
         {
-            assert(GetIBBindingTracker().GetBindingIndices().size() == 1);
+            assert(GetIBBindingTracker().GetBindingCount() == 1);
             m_pParentDevice->GetPipelineState().GetInputAssembly().SetIndexBuffer(*m_pParentDevice, nullptr, 0);
         }
 
@@ -691,6 +699,11 @@ namespace D3D9on12
             }
         }
 
+        if (m_isTrackedInStatistics)
+        {
+            m_pParentDevice->GetDataLogger().RemoveResource(m_statisticsType, m_statisticsSize, m_statisticsIsSystemMemory);
+        }
+
         m_pParentDevice->m_lockedResourceRanges.GetLocked()->erase(this);
 
         m_pResource.reset(nullptr);
@@ -764,6 +777,31 @@ namespace D3D9on12
         return InitInternal(createArgs.GetCreateArgs(), true, std::move(pResource), DoNotCreateAsTypelessResource);
     }
 
+    D3DRESOURCETYPE Resource::GetStatisticsResourceType(const D3DDDI_RESOURCEFLAGS& flags)
+    {
+        if (flags.VertexBuffer)
+        {
+            return D3DRTYPE_VERTEXBUFFER;
+        }
+        else if (flags.IndexBuffer)
+        {
+            return D3DRTYPE_INDEXBUFFER;
+        }
+        else if (flags.CubeMap)
+        {
+            return D3DRTYPE_CUBETEXTURE;
+        }
+        else if (flags.Volume)
+        {
+            return D3DRTYPE_VOLUMETEXTURE;
+        }
+        else if (flags.Texture)
+        {
+            return D3DRTYPE_TEXTURE;
+        }
+        return D3DRTYPE_SURFACE;
+    }
+
     HRESULT Resource::InitInternal(_In_ D3DDDIARG_CREATERESOURCE2 &createArgs, bool onlyFirstSurfInitialized, unique_comptr<D3D12TranslationLayer::Resource> pAlreadyCreatedResource, bool DoNotCreateAsTypelessResource)
     {
 #if DBG
@@ -865,6 +903,7 @@ namespace D3D9on12
                 + 1;
 
         m_lockData.resize(m_numSubresources);
+        m_asyncDiscardStorage.SetNumSubresources(m_numSubresources);
         m_appLinearRepresentation.m_systemData.resize(m_numSubresources);
         m_physicalLinearRepresentation.m_footprints.resize(m_numSubresources);
         m_physicalLinearRepresentation.m_rowPitces.resize(m_numSubresources);
@@ -1121,29 +1160,23 @@ namespace D3D9on12
 
             if (SUCCEEDED(hr))
             {
+                // RTVs, DSVs and SRVs are only created the first time they're bound or cleared since most
+                // textures are only ever sampled through a single view permutation, if at all.
                 // DXGI swapchain resources aren't created as typeless resources so we can't
                 // make a view with the SRGB variant of the resource format
                 if (NeedsRenderTarget(createArgs.Flags, createArgs.Pool))
                 {
-                    CreateRenderTargetViews(m_ViewFormat, GenerateSRGBViews);
+                    InitRenderTargetViews(m_ViewFormat, GenerateSRGBViews);
                 }
 
                 if (NeedsDepthStencil(createArgs.Flags, createArgs.Pool))
                 {
-                    CreateDepthStencilViews();
+                    m_dsvFormat = m_ViewFormat;
                 }
 
                 if (NeedsShaderResourceView(createArgs.Flags, createArgs.Pool))
                 {
-                    m_shaderResourceViews[ShaderResourceViewFlags::None] = std::unique_ptr<D3D12TranslationLayer::SRV>(
-                        CreateShaderResourceView(ShaderResourceViewFlags::None));
-                    m_srvTextureType = ConvertShaderResourceDimensionToTextureType(m_shaderResourceViews[ShaderResourceViewFlags::None]->GetDesc12().ViewDimension);
-
-                    if (GenerateSRGBViews)
-                    {
-                        m_shaderResourceViews[ShaderResourceViewFlags::SRGBEnabled] = std::unique_ptr<D3D12TranslationLayer::SRV>(
-                            CreateShaderResourceView(ShaderResourceViewFlags::SRGBEnabled));
-                    }
+                    m_srvTextureType = ConvertShaderResourceDimensionToTextureType(GetShaderResourceViewDesc().ViewDimension);
                 }
 
                 if (NeedsVideoDecoderOutputView(createArgs.Flags, createArgs.Pool))
@@ -1155,6 +1188,16 @@ namespace D3D9on12
                 {
                     CreateVideoProcessorOutputViews();
                 }
+
+                if (m_isTrackedInStatistics)
+                {
+                    m_pParentDevice->GetDataLogger().RemoveResource(m_statisticsType, m_statisticsSize, m_statisticsIsSystemMemory);
+                }
+                m_statisticsType = GetStatisticsResourceType(createArgs.Flags);
+                m_statisticsSize = m_totalSize;
+                m_statisticsIsSystemMemory = m_isD3D9SystemMemoryPool;
+                m_isTrackedInStatistics = true;
+                m_pParentDevice->GetDataLogger().AddResource(m_statisticsType, m_statisticsSize, m_statisticsIsSystemMemory);
             }
         }
         else
@@ -1218,7 +1261,7 @@ namespace D3D9on12
         }
         if (m_renderTargetViews.size() > 0)
         {
-            Check9on12(m_renderTargetViews[SubResourceIndex] != nullptr);
+            Check9on12(SubResourceIndex < m_renderTargetViews.size());
 
             // From MSDN: D3DRS_SRGBWRITEENABLE is honored while performing a clear of the render target
             bool srgbEnabled = m_pParentDevice->GetPipelineState().GetPixelStage().GetSRGBWriteEnable();
@@ -1236,7 +1279,8 @@ namespace D3D9on12
     HRESULT Resource::ClearDepthStencil(UINT flag, _In_ const RECT *dstRects, _In_ UINT numRects, float depthValue, UINT stencilValue)
     {
         Check9on12(flag & (D3DCLEAR_ZBUFFER | D3DCLEAR_STENCIL));
-        Check9on12(m_pDepthStencilViews[D3D12_DSV_FLAG_NONE] != nullptr);
+        D3D12TranslationLayer::DSV* pDSV = GetDepthStencilView(D3D12_DSV_FLAG_NONE);
+        Check9on12(pDSV != nullptr);
 
         D3D12_CLEAR_FLAGS clearFlag = {};
         if (flag & D3DCLEAR_ZBUFFER)
@@ -1249,7 +1293,7 @@ namespace D3D9on12
             clearFlag |= D3D12_CLEAR_FLAG_STENCIL;
         }
 
-        m_pParentDevice->GetContext().ClearDepthStencilView(m_pDepthStencilViews[D3D12_DSV_FLAG_NONE], clearFlag, depthValue, static_cast<UINT8>(stencilValue), numRects, dstRects);
+        m_pParentDevice->GetContext().ClearDepthStencilView(pDSV, clearFlag, depthValue, static_cast<UINT8>(stencilValue), numRects, dstRects);
 
         return S_OK;
     }
@@ -1313,16 +1357,22 @@ namespace D3D9on12
         _Out_opt_ HANDLE *phCookie)
     {
         Check9on12(m_IsLockable);
-        //TODO: When they do a lock discard combined with a 'MightDrawFromLocked' flag
-        //      we might have to version the buffer.
-        if (flags.MightDrawFromLocked && flags.Discard)
-        {
-            PrintDebugMessage("Warning: Lock with flags 'MightDrawFromLocked' and 'Discard'. This is not implemented properly");
-        }
 
         if (flags.NotifyOnly)
         {
             Check9on12(IsSystemMemory());
+            if (HasPendingSystemMemoryCopies())
+            {
+                if (bAsyncLock)
+                {
+                    // Finishing the copies maps the staging resources through the immediate context, which only the
+                    // device thread may use. Like the other async locks below that would need synchronization, E_NOTIMPL
+                    // makes the runtime fall back to a synchronous Lock on the device thread, which resolves them.
+                    return E_NOTIMPL;
+                }
+                ResolvePendingSystemMemoryCopies(device);
+            }
+            Check9on12(!HasPendingSystemMemoryCopies());
             return S_OK;
         }
 
@@ -1348,7 +1398,14 @@ namespace D3D9on12
         D3D12TranslationLayer::SafeRenameResourceCookie pCookieProtector;
         if (bAsyncLock)
         {
-            // TODO: (11369816) Not supporting lock async with non-buffers or CPU readable resources
+            if (flags.Discard &&
+                m_logicalDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER &&
+                (m_CpuAccessFlags & D3D12TranslationLayer::RESOURCE_CPU_ACCESS_READ) == 0)
+            {
+                return LockAsyncTextureDiscard(subresourceIndex, flags, lockRange, pSurfData, pitch, slicePitch, phCookie);
+            }
+
+            // TODO: (11369816) Not supporting lock async with CPU readable resources or non-discard texture locks
             if ((!flags.Discard && !flags.NoOverwrite) ||
                 (m_CpuAccessFlags & D3D12TranslationLayer::RESOURCE_CPU_ACCESS_READ) ||
                 m_logicalDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
@@ -1414,6 +1471,27 @@ namespace D3D9on12
 
         mapType = GetMapTypeFlag(flags.ReadOnly, flags.WriteOnly, flags.Discard, flags.NoOverwrite, m_isDecodeCompressedBuffer, m_pResource->AppDesc()->CPUAccessFlags());
 
+        // A discard renames an upload heap buffer to a fresh allocation without waiting, so draws issued while the app
+        // still holds the lock (MightDrawFromLocked) source that allocation directly. Recursive locks must keep returning
+        // and drawing from the same version, so only the first lock discards.
+        // Static vertex and index buffers live in the default heap on discrete GPUs, where a discard writes to staging
+        // memory that's only copied into the buffer on unlock, so draws from the locked buffer can't see it.
+        if (mapType == D3D12TranslationLayer::MAP_TYPE_WRITE_DISCARD &&
+            m_logicalDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            if (m_TranslationLayerCreateArgs.m_heapDesc.Properties.Type != D3D12_HEAP_TYPE_UPLOAD)
+            {
+                if (flags.MightDrawFromLocked)
+                {
+                    PrintDebugMessage("Warning: Lock with flags 'MightDrawFromLocked' and 'Discard' on a default heap buffer. This is not implemented properly");
+                }
+            }
+            else if (m_lockData[subresourceIndex].m_LockCount > 0)
+            {
+                mapType = D3D12TranslationLayer::MAP_TYPE_WRITE_NOOVERWRITE;
+            }
+        }
+
         if (RegistryConstants::g_cLockDiscardOptimization)
         {
             if (mapType == D3D12TranslationLayer::MAP_TYPE_WRITE_DISCARD)
@@ -1426,71 +1504,30 @@ namespace D3D9on12
                     lockRange.Range.Size = (UINT) this->m_totalSize;
                 }
 
-                // Check if buffer is in the map
-                // If it is, get a list of previously mapped ranges
+                const UINT currentRangeStart = lockRange.Range.Offset;
+                const UINT currentRangeEnd = lockRange.Range.Offset + lockRange.Range.Size;
 
+                // Check if buffer is in the map
+                // If it is, check the current range against the previously mapped ranges
                 auto lockedResourceRanges = device.m_lockedResourceRanges.GetLocked();
                 auto it = lockedResourceRanges->find(this);
-                if (it != lockedResourceRanges->end()) {
-
-                    // it->second has the mapped ranges vector corresponding to it->first == this
-
-                    bool overlapsWithPreviouslyMappedRanges = false;
-                    bool mergedWithExistingMappedRange = false;
-
-                    UINT currentRangeStart = lockRange.Range.Offset;
-                    UINT currentRangeEnd = lockRange.Range.Offset + lockRange.Range.Size;
-
-                    // Compare current range with previously mapped ranges
-                    for (auto& mappedRange : it->second)
-                    {
-                        UINT mappedRangeStart = mappedRange.Range.Offset;
-                        UINT mappedRangeEnd = mappedRange.Range.Offset + mappedRange.Range.Size;
-
-                        if (((currentRangeStart >= mappedRangeStart) && (currentRangeStart < mappedRangeEnd)) ||
-                            ((currentRangeEnd >= mappedRangeStart) && (currentRangeEnd < mappedRangeEnd)))
-                        {
-                            overlapsWithPreviouslyMappedRanges = true;
-                            break;
-                        }
-
-                        // If the current range is a neighbor of an existing mapped range, merge it with the neighbor
-                        if (currentRangeStart == mappedRangeEnd)
-                        {
-                            mappedRange.Range.Size += lockRange.Range.Size;
-
-                            mergedWithExistingMappedRange = true;
-                            break;
-                        }
-                        if (currentRangeEnd == mappedRangeStart)
-                        {
-                            mappedRange.Range.Offset = lockRange.Range.Offset;
-                            mappedRange.Range.Size += lockRange.Range.Size;
-
-                            mergedWithExistingMappedRange = true;
-                            break;
-                        }
-                    }
-
-                    // If the newly mapped range doesn't intersect previously mapped ranges - add it to the list and change flag to NO_OVERWRITE
-                    if (!overlapsWithPreviouslyMappedRanges)
+                if (it != lockedResourceRanges->end())
+                {
+                    // If the newly mapped range doesn't intersect previously mapped ranges - add it to the set and change flag to NO_OVERWRITE
+                    if (!it->second.Overlaps(currentRangeStart, currentRangeEnd))
                     {
                         mapType = D3D12TranslationLayer::MAP_TYPE_WRITE_NOOVERWRITE;
                     }
-                    else // Else clear the list of ranges, add the current range, and keep the DISCARD flag
+                    else // Else clear the set of ranges, add the current range, and keep the DISCARD flag
                     {
-                        it->second.clear();
+                        it->second.Clear();
                     }
 
-                    if (!mergedWithExistingMappedRange)
-                    {
-                        it->second.push_back(lockRange);
-                    }
+                    it->second.Insert(currentRangeStart, currentRangeEnd);
                 }
                 else
                 {
-                    std::vector<LockRange> lockedRange = { lockRange };
-                    lockedResourceRanges->insert({ this, lockedRange });
+                    lockedResourceRanges->try_emplace(this).first->second.Insert(currentRangeStart, currentRangeEnd);
                 }
             }
         }
@@ -1509,8 +1546,16 @@ namespace D3D9on12
         }
         else
         {
+            // Make room up front so recording the map type after a successful map can't throw
+            m_lockData[subresourceIndex].m_MapTypes.reserve(m_lockData[subresourceIndex].m_LockCount + 1); // throw( bad_alloc )
+
             D3D12TranslationLayer::MappedSubresource mappedData = {};
-            bool bResourceMapped = device.GetContext().Map(m_pResource.get(), subresourceIndex, mapType, flags.DoNotWait, pBox, &mappedData);
+            bool bResourceMapped;
+            {
+                // Async locks are on the app thread, which mustn't touch the device's counters
+                ScopedCounterTimer stallTimer(device.GetDataLogger(), DeviceStatistics::LockStallMicroseconds, !flags.DoNotWait && !bAsyncLock);
+                bResourceMapped = device.GetContext().Map(m_pResource.get(), subresourceIndex, mapType, flags.DoNotWait, pBox, &mappedData);
+            }
             if (!bResourceMapped)
             {
                 return D3DERR_WASSTILLDRAWING;
@@ -1518,6 +1563,7 @@ namespace D3D9on12
             pSurfData = (byte*)mappedData.pData;
             pitch = static_cast<UINT>(mappedData.RowPitch);
             slicePitch = static_cast<UINT>(mappedData.DepthPitch);
+            m_lockData[subresourceIndex].m_MapTypes.push_back(mapType);
         }
 
         //We had better of got some data to return
@@ -1525,7 +1571,17 @@ namespace D3D9on12
          
         if (mapType != D3D12TranslationLayer::MAP_TYPE::MAP_TYPE_READ)
         {
-            NotifyResourceChanged();
+            // A discard leaves the whole buffer undefined, otherwise only the locked range can change
+            if (pBox && !flags.Discard && m_logicalDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+            {
+                NotifyResourceChanged(pBox->left, pBox->right - pBox->left);
+            }
+            else
+            {
+                NotifyResourceChanged();
+            }
+
+            m_indexBufferShadow.Lock(pSurfData, bAsyncLock, m_lockData[subresourceIndex].m_LockCount > 0);
         }
 
         // No more exceptions
@@ -1544,9 +1600,24 @@ namespace D3D9on12
         Check9on12(m_lockData[subresourceIndex].m_LockCount > 0);
         m_lockData[subresourceIndex].m_LockCount--;
 
+        if (bAsyncUnlock && m_asyncDiscardStorage.GetOpen(subresourceIndex))
+        {
+            // Nothing is mapped, the storage is uploaded by the Rename that follows
+            if (m_lockData[subresourceIndex].m_LockCount == 0)
+            {
+                m_asyncDiscardStorage.Close(subresourceIndex);
+            }
+            return;
+        }
+
         const D3DDDI_LOCKFLAGS &lockFlags = m_lockData[subresourceIndex].m_Flags;
         bool bLockingSubrange = IsLockingSubrange<D3DDDI_LOCKFLAGS>(lockFlags);
         const D3D12_BOX *pReadWriteBox = (bLockingSubrange) ? &m_lockData[subresourceIndex].m_Box : nullptr;
+
+        // Mirror what the app wrote into the index buffer shadow while the data is still mapped
+        m_indexBufferShadow.Unlock(m_lockData[subresourceIndex].m_LockCount == 0,
+            pReadWriteBox ? pReadWriteBox->left : 0u,
+            pReadWriteBox ? pReadWriteBox->right : static_cast<UINT>(m_desc.Width));
         
         // In the async case, we need to make sure that we don't touch m_pResource's identity,
         // as this could be changing out from under us. However, m_pResource is safe to query
@@ -1559,11 +1630,106 @@ namespace D3D9on12
         }
         else
         {
-            D3D12TranslationLayer::MAP_TYPE mapType = GetMapTypeFlag(lockFlags.ReadOnly, lockFlags.WriteOnly, lockFlags.Discard, lockFlags.NoOverwrite, m_isDecodeCompressedBuffer, pResourceToUnmap->AppDesc()->CPUAccessFlags());
+            // Recursive locks can map differently than the first one (e.g. a discard followed by no-overwrite locks),
+            // so unmap with what the matching lock actually used
+            std::vector<D3D12TranslationLayer::MAP_TYPE> &mapTypes = m_lockData[subresourceIndex].m_MapTypes;
+            D3D12TranslationLayer::MAP_TYPE mapType;
+            if (!mapTypes.empty())
+            {
+                mapType = mapTypes.back();
+                mapTypes.pop_back();
+            }
+            else
+            {
+                mapType = GetMapTypeFlag(lockFlags.ReadOnly, lockFlags.WriteOnly, lockFlags.Discard, lockFlags.NoOverwrite, m_isDecodeCompressedBuffer, pResourceToUnmap->AppDesc()->CPUAccessFlags());
+            }
             device.GetContext().Unmap(pResourceToUnmap, subresourceIndex, mapType, pReadWriteBox);
         }
     }
 
+    size_t Resource::GetAsyncDiscardStorageSize(UINT subresourceIndex)
+    {
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT &footprint = GetSubresourceFootprint(subresourceIndex);
+        return size_t(footprint.Footprint.RowPitch) * m_physicalLinearRepresentation.m_numRows[subresourceIndex] * footprint.Footprint.Depth;
+    }
+
+    HRESULT Resource::LockAsyncTextureDiscard(UINT subresourceIndex, D3DDDI_LOCKFLAGS flags, const LockRange &lockRange, _Out_ VOID* &pSurfData, _Out_ UINT &pitch, _Out_ UINT &slicePitch, _Out_opt_ HANDLE *phCookie)
+    {
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT &footprint = GetSubresourceFootprint(subresourceIndex);
+        if (m_lockData[subresourceIndex].m_LockCount == 0)
+        {
+            if (phCookie == nullptr)
+            {
+                // Planar textures would need a cookie per plane
+                return E_NOTIMPL;
+            }
+
+            const UINT rowPitch = footprint.Footprint.RowPitch;
+            const UINT depthPitch = rowPitch * m_physicalLinearRepresentation.m_numRows[subresourceIndex];
+            *phCookie = m_asyncDiscardStorage.Open(subresourceIndex, rowPitch, depthPitch, GetAsyncDiscardStorageSize(subresourceIndex));
+        }
+
+        // Recursive locks reuse the storage of the first lock
+        AsyncDiscardStorage *pStorage = m_asyncDiscardStorage.GetOpen(subresourceIndex);
+        if (pStorage == nullptr)
+        {
+            return E_NOTIMPL;
+        }
+
+        UINT left = 0, top = 0, front = 0;
+        if (flags.AreaValid)
+        {
+            left = lockRange.Area.left;
+            top = lockRange.Area.top;
+        }
+        else if (flags.BoxValid)
+        {
+            left = lockRange.Box.Left;
+            top = lockRange.Box.Top;
+            front = lockRange.Box.Front;
+        }
+        // Validation of ranges/rects/boxes is debug-only in 9, so sanitize them here.
+        left = min(left, footprint.Footprint.Width);
+        top = min(top, footprint.Footprint.Height);
+        front = min(front, footprint.Footprint.Depth);
+
+        const UINT blockSize = GetBlockWidth(footprint.Footprint.Format);
+        pSurfData = pStorage->m_data.data()
+            + front * pStorage->m_slicePitch
+            + (top / blockSize) * pStorage->m_rowPitch
+            + (left / blockSize) * GetBytesPerUnit(footprint.Footprint.Format);
+        pitch = pStorage->m_rowPitch;
+        slicePitch = pStorage->m_slicePitch;
+
+        m_lockData[subresourceIndex].m_LockCount++;
+        return S_OK;
+    }
+
+    void Resource::RenameTexture(Device& device, std::unique_ptr<AsyncDiscardStorage> pStorage)
+    {
+        D3D11_SUBRESOURCE_DATA subresourceData =
+        {
+            pStorage->m_data.data(),
+            pStorage->m_rowPitch,
+            pStorage->m_slicePitch
+        };
+        UINT8 MipLevel, PlaneSlice;
+        UINT16 ArraySlice;
+        D3D12TranslationLayer::DecomposeSubresourceIdxExtended(pStorage->m_subresourceIndex,
+            m_pResource->AppDesc()->MipLevels(),
+            m_pResource->AppDesc()->ArraySize(), MipLevel, ArraySlice, PlaneSlice);
+
+        // The data is staged through the context's upload heap, which is recycled once the GPU copy's fence completes,
+        // so the texture isn't waited on and the storage can be reused as soon as this returns
+        device.GetContext().UpdateSubresources(m_pResource.get(),
+            D3D12TranslationLayer::CSubresourceSubset(1, 1, m_pResource->SubresourceMultiplier(), MipLevel, ArraySlice, PlaneSlice),
+            &subresourceData,
+            nullptr,
+            D3D12TranslationLayer::ImmediateContext::UpdateSubresourcesFlags::ScenarioImmediateContext);
+
+        m_asyncDiscardStorage.Recycle(std::move(pStorage));
+    }
+
     HRESULT Resource::PreBind()
     {
         return S_OK;
@@ -1571,7 +1737,19 @@ namespace D3D9on12
 
     void Resource::GetTriFanIB(_Out_ InputBuffer& convertedIB, _In_ UINT indexOffsetInBytes, _In_ UINT indexCount, _In_ UINT ibStride)
     {
-        if (IsTriangleFanIBCacheDirty(indexOffsetInBytes))
+        const InputBuffer *pCachedIB = m_TriFanIBCache.Find(indexOffsetInBytes, indexCount, ibStride);
+        if (pCachedIB)
+        {
+            // We can use the previously stored converted index buffer since its range hasn't changed since the last conversion.
+            convertedIB = *pCachedIB;
+        }
+        else if (m_indexBufferShadow.IsValid())
+        {
+            // The shadow mirrors every write since it was filled, so the conversion doesn't need to touch the GPU
+            D3D9on12::InputAssembly::CreateTriangleListIBFromTriangleFanIB(*m_pParentDevice, m_indexBufferShadow.GetData(), ibStride, indexOffsetInBytes, indexCount, convertedIB);
+            m_TriFanIBCache.Insert(convertedIB, indexOffsetInBytes, indexCount, ibStride);
+        }
+        else
         {
             D3D12TranslationLayer::Resource *pMappableIndexBuffer = GetUnderlyingResource();
 
@@ -1585,39 +1763,54 @@ namespace D3D9on12
             }
 
             // Read from GPU and set a flag to unmap this after the draw operations
+            m_pParentDevice->GetDataLogger().AddToCounter(DeviceStatistics::ReadbackWaits, 1);
             D3D12TranslationLayer::MappedSubresource MappedResult;
             m_pParentDevice->GetContext().Map(pMappableIndexBuffer, 0, D3D12TranslationLayer::MAP_TYPE_READ, false, nullptr, &MappedResult);
             const void* pSrcIndexBuffer = (void *)MappedResult.pData;
 
+            // Keep a CPU copy around so later conversions from this index buffer can skip the readback
+            FillIndexBufferShadow(pSrcIndexBuffer);
+
             D3D9on12::InputAssembly::CreateTriangleListIBFromTriangleFanIB(*m_pParentDevice, pSrcIndexBuffer, ibStride, indexOffsetInBytes, indexCount, convertedIB);
-            UpdateTriangleFanIBCache(convertedIB, indexOffsetInBytes);
+            m_TriFanIBCache.Insert(convertedIB, indexOffsetInBytes, indexCount, ibStride);
 
             m_pParentDevice->GetContext().Unmap(pMappableIndexBuffer, 0, D3D12TranslationLayer::MAP_TYPE_READ, nullptr);
-        }
-        else
-        {
-            // We can use the previously stored converted index buffer since the resource hasn't changed since the last conversion.
-            convertedIB = m_TriFanIBCache.m_TriangleFanConvertedTriangleListIndexBuffer;
+            m_pParentDevice->RecycleStagingReadbackResource(std::move(pReadbackBuffer));
         }
     }
 
-    bool Resource::IsTriangleFanIBCacheDirty(UINT baseIndexLocation)
+    void Resource::NotifyResourceChanged(UINT offsetInBytes, UINT sizeInBytes)
     {
-        return  (m_TriFanIBCache.m_dirtyFlag) ||
-            (baseIndexLocation != m_TriFanIBCache.m_baseIndexOffsetInBytes);
+        m_TriFanIBCache.Invalidate(offsetInBytes, sizeInBytes);
     }
 
-    void Resource::UpdateTriangleFanIBCache(InputBuffer& newIBToStore, UINT indexOffsetInBytes)
+    void Resource::FillIndexBufferShadow(_In_ const void* pIndexData)
     {
-        m_TriFanIBCache.m_TriangleFanConvertedTriangleListIndexBuffer = newIBToStore;
-        m_TriFanIBCache.m_baseIndexOffsetInBytes = indexOffsetInBytes;
-        m_TriFanIBCache.m_dirtyFlag = false;
+        bool isLocked = false;
+        for (const LockData &lockData : m_lockData)
+        {
+            isLocked |= lockData.m_LockCount > 0;
+        }
+
+        m_indexBufferShadow.Fill(m_pParentDevice->m_indexBufferShadowMemoryUsage, RegistryConstants::g_cIndexBufferShadowMemoryLimit,
+            pIndexData, m_desc.Width, isLocked);
     }
 
-    void Resource::NotifyResourceChanged()
+    void Resource::UpdateIndexBufferShadowFromCopy(const ResourceCopyArgs& args)
     {
-        m_TriFanIBCache.m_baseIndexOffsetInBytes = 0;
-        m_TriFanIBCache.m_dirtyFlag = true;
+        if (!m_indexBufferShadow.IsValid())
+        {
+            return;
+        }
+
+        // Copies can only be mirrored when the source data is already visible to the CPU
+        Resource &source = args.m_source;
+        const BYTE *pSourceData = source.IsSystemMemory() ?
+            static_cast<const BYTE*>(source.GetSystemMemoryBase()) :
+            source.m_indexBufferShadow.GetData();
+
+        m_indexBufferShadow.Copy(args.m_destinationX, pSourceData, static_cast<UINT>(source.GetDesc().Width),
+            args.m_sourceBox.left, args.m_sourceBox.right, args.IsBufferBlit());
     }
 
     D3D12_PLACED_SUBRESOURCE_FOOTPRINT &Resource::GetSubresourceFootprint(UINT subresource)
@@ -1637,7 +1830,7 @@ namespace D3D9on12
     }
 
     ShaderConv::TEXTURETYPE Resource::GetShaderResourceTextureType() {
-        Check9on12(GetShaderResourceView() != nullptr);
+        Check9on12(m_pResource->AppDesc()->BindFlags() & D3D12TranslationLayer::RESOURCE_BIND_SHADER_RESOURCE);
 
         return m_srvTextureType;
     }
@@ -1663,10 +1856,9 @@ namespace D3D9on12
             D3D12TranslationLayer::RESOURCE_CPU_ACCESS_READ,
             (D3D12TranslationLayer::RESOURCE_BIND_FLAGS)0,
             origAppDesc.ResourceDimension());
-            
 
-        auto pResource = D3D12TranslationLayer::Resource::CreateResource(
-            &m_pParentDevice->GetContext(), args, D3D12TranslationLayer::ResourceAllocationContext::ImmediateContextThreadTemporary);
+        // Callers hand the copy back with Device::RecycleStagingReadbackResource once they're done reading it
+        auto pResource = m_pParentDevice->AcquireStagingReadbackResource(args);
 
         m_pParentDevice->GetContext().ResourceCopy(pResource.get(), GetUnderlyingResource());
         return std::move(pResource);
@@ -1712,6 +1904,17 @@ namespace D3D9on12
         return m_pBackingShaderResource;
     }
 
+    Resource *Resource::GetBackingPlainResourceForGeneration(UINT64 copyGeneration)
+    {
+        if (m_pBackingShaderResource && m_backingShaderResourceGeneration == copyGeneration)
+        {
+            return m_pBackingShaderResource;
+        }
+
+        m_backingShaderResourceGeneration = copyGeneration;
+        return GetBackingPlainResource();
+    }
+
     bool Resource::IsSRGBCompatibleTexture()
     {
         DXGI_FORMAT format = GetLogicalDesc().Format;
@@ -1758,85 +1961,76 @@ namespace D3D9on12
             // "Only the formats that pass the CheckDeviceFormat with the usage flag D3DUSAGE_QUERY_SRGBWRITE 
             // can be linearized. The render state D3DRS_SRGBWRITEENABLE is ignored for the rest."
             // https://msdn.microsoft.com/en-us/library/windows/desktop/bb173460(v=vs.85).aspx
-            if (srgbEnabled && IsSRGBCompatible(m_desc.Format))
-            {
-                Check9on12(subresourceIndex < m_SRGBRenderTargetViews.size());
-                return m_SRGBRenderTargetViews[subresourceIndex].get();
-            }
-            else
+            const bool useSRGBView = srgbEnabled && IsSRGBCompatible(m_desc.Format);
+            std::vector<std::unique_ptr<D3D12TranslationLayer::RTV>>& views = useSRGBView ? m_SRGBRenderTargetViews : m_renderTargetViews;
+            Check9on12(subresourceIndex < views.size());
+
+            if (!views[subresourceIndex])
             {
-                Check9on12(subresourceIndex < m_renderTargetViews.size());
-                return m_renderTargetViews[subresourceIndex].get();
+                views[subresourceIndex] = std::unique_ptr<D3D12TranslationLayer::RTV>(CreateRenderTargetView(subresourceIndex, useSRGBView));
             }
+            return views[subresourceIndex].get();
         }
     }
 
-    void Resource::CreateRenderTargetViews(DXGI_FORMAT rtvFormat, bool GenerateSRGBRTV)
+    void Resource::InitRenderTargetViews(DXGI_FORMAT rtvFormat, bool GenerateSRGBRTV)
     {
         Check9on12(m_logicalDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D);
         const bool srgbCompatible = IsSRGBCompatible(rtvFormat);
         GenerateSRGBRTV = GenerateSRGBRTV && srgbCompatible;
 
+        // Only the slots are allocated here, the views themselves are created by GetRenderTargetView
         m_renderTargetViews = std::vector<std::unique_ptr<D3D12TranslationLayer::RTV>>(m_numSubresources);
         if (GenerateSRGBRTV)
         {
             m_SRGBRenderTargetViews = std::vector<std::unique_ptr<D3D12TranslationLayer::RTV>>(m_numSubresources);
         }
+    }
+
+    D3D12TranslationLayer::RTV* Resource::CreateRenderTargetView(UINT subresourceIndex, bool srgbEnabled)
+    {
+        Check9on12(subresourceIndex < m_numSubresources);
+
+        // Subresources are laid out mip-major within each array slice
+        const UINT arraySlice = subresourceIndex / m_logicalDesc.MipLevels;
+        const UINT mipLevel = subresourceIndex % m_logicalDesc.MipLevels;
 
         D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+        rtvDesc.Format = srgbEnabled ? ConvertToSRGB(m_ViewFormat) : m_ViewFormat;
 
-        UINT subresourceIndex = 0;
-        for (UINT arraySlice = 0; arraySlice < GetArraySize(); arraySlice++)
+        if (m_logicalDesc.DepthOrArraySize > 1)
         {
-            for (UINT mipLevel = 0; mipLevel < m_logicalDesc.MipLevels; mipLevel++)
+            if (m_logicalDesc.SampleDesc.Count > 1)
             {
-                if (m_logicalDesc.DepthOrArraySize > 1)
-                {
-                    if (m_logicalDesc.SampleDesc.Count > 1)
-                    {
-                        rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DMS;
-                        rtvDesc.Texture2DMSArray.ArraySize = 1;
-                        rtvDesc.Texture2DMSArray.FirstArraySlice = arraySlice;
-                    }
-                    else
-                    {
-                        rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
-                        rtvDesc.Texture2DArray.MipSlice = mipLevel;
-                        rtvDesc.Texture2DArray.FirstArraySlice = arraySlice;
-                        rtvDesc.Texture2DArray.ArraySize = 1;
-                        rtvDesc.Texture2DArray.PlaneSlice = 0;
-                    }
-                }
-                else
-                {
-                    if (m_logicalDesc.SampleDesc.Count > 1)
-                    {
-                        assert(m_logicalDesc.MipLevels == 1);
-                        rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DMS;
-                    }
-                    else
-                    {
-                        rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
-                        rtvDesc.Texture2D.MipSlice = mipLevel;
-                        rtvDesc.Texture2D.PlaneSlice = 0;
-                    }
-                }
-
-                Check9on12(subresourceIndex < m_renderTargetViews.size());
-
-                rtvDesc.Format = rtvFormat;
-                m_renderTargetViews[subresourceIndex] = std::unique_ptr<D3D12TranslationLayer::RTV>(
-                    new D3D12TranslationLayer::RTV(&m_pParentDevice->GetContext(), rtvDesc, *m_pResource));
-
-                if (GenerateSRGBRTV)
-                {
-                    rtvDesc.Format = ConvertToSRGB(rtvFormat);
-                    m_SRGBRenderTargetViews[subresourceIndex] = std::unique_ptr<D3D12TranslationLayer::RTV>(
-                        new D3D12TranslationLayer::RTV(&m_pParentDevice->GetContext(), rtvDesc, *m_pResource));
-                }
-                subresourceIndex++;
+                rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DMS;
+                rtvDesc.Texture2DMSArray.ArraySize = 1;
+                rtvDesc.Texture2DMSArray.FirstArraySlice = arraySlice;
+            }
+            else
+            {
+                rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
+                rtvDesc.Texture2DArray.MipSlice = mipLevel;
+                rtvDesc.Texture2DArray.FirstArraySlice = arraySlice;
+                rtvDesc.Texture2DArray.ArraySize = 1;
+                rtvDesc.Texture2DArray.PlaneSlice = 0;
             }
         }
+        else
+        {
+            if (m_logicalDesc.SampleDesc.Count > 1)
+            {
+                assert(m_logicalDesc.MipLevels == 1);
+                rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DMS;
+            }
+            else
+            {
+                rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
+                rtvDesc.Texture2D.MipSlice = mipLevel;
+                rtvDesc.Texture2D.PlaneSlice = 0;
+            }
+        }
+
+        return new D3D12TranslationLayer::RTV(&m_pParentDevice->GetContext(), rtvDesc, *m_pResource);
     }
 
     void Resource::CreateVideoDecoderOutputViews()
@@ -1882,53 +2076,49 @@ namespace D3D9on12
         Check9on12(flags < _countof(g_cPossibleDepthStencilStates));
         // If we don't have a stencil plane, we can ignore DSV_STENCIL_READ_ONLY
         const UINT DSVIndex = FormatSupportsStencil(m_dsvFormat) ? flags : (flags & D3D12_DSV_FLAG_READ_ONLY_DEPTH);
+        if (m_pDepthStencilViews[DSVIndex] == nullptr)
+        {
+            CreateDepthStencilView(DSVIndex);
+        }
         return m_pDepthStencilViews[DSVIndex];
     }
 
-    void Resource::CreateDepthStencilViews()
+    void Resource::CreateDepthStencilView(UINT dsvIndex)
     {
-        m_dsvFormat = m_ViewFormat;
+        Check9on12(m_dsvFormat != DXGI_FORMAT_UNKNOWN);
+        Check9on12(m_pDepthStencilViews[dsvIndex] == nullptr);
+        Check9on12(m_numArrayLevels == 1); // Not supporting DSV cubemaps yet
 
-        for (size_t i = 0; i < _countof(g_cPossibleDepthStencilStates); i++)
+        D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+        dsvDesc.Format = m_dsvFormat;
+        dsvDesc.Flags = g_cPossibleDepthStencilStates[dsvIndex];
+        switch (m_logicalDesc.Dimension)
         {
-            D3D12_DSV_FLAGS flag = g_cPossibleDepthStencilStates[i];
-
-            if ((flag & D3D12_DSV_FLAG_READ_ONLY_STENCIL) && FormatSupportsStencil(m_ViewFormat) == false)
+            case D3D12_RESOURCE_DIMENSION_TEXTURE2D:
             {
-                continue;
-            }
-            Check9on12(m_numArrayLevels == 1); // Not supporting DSV cubemaps yet
-            D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
-            dsvDesc.Format = m_ViewFormat;
-            dsvDesc.Flags = flag;
-            switch (m_logicalDesc.Dimension)
-            {
-                case D3D12_RESOURCE_DIMENSION_TEXTURE2D:
+                if (m_logicalDesc.SampleDesc.Count > 1)
                 {
-                    if (m_logicalDesc.SampleDesc.Count > 1)
-                    {
-                        dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2DMS;
-                    }
-                    else
-                    {
-                        dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-                        dsvDesc.Texture2D.MipSlice = 0;
-                    }
-                    break;
+                    dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2DMS;
                 }
-                case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
-                case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
-                case D3D12_RESOURCE_DIMENSION_UNKNOWN:
-                case D3D12_RESOURCE_DIMENSION_BUFFER:
-                default:
+                else
                 {
-                    Check9on12(FALSE);
-                    break;
+                    dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+                    dsvDesc.Texture2D.MipSlice = 0;
                 }
+                break;
+            }
+            case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
+            case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
+            case D3D12_RESOURCE_DIMENSION_UNKNOWN:
+            case D3D12_RESOURCE_DIMENSION_BUFFER:
+            default:
+            {
+                Check9on12(FALSE);
+                break;
             }
-
-            m_pDepthStencilViews[i] = new (m_depthStencilViewSpace + i * sizeof(D3D12TranslationLayer::DSV)) D3D12TranslationLayer::DSV(&m_pParentDevice->GetContext(), dsvDesc, *m_pResource);
         }
+
+        m_pDepthStencilViews[dsvIndex] = new (m_depthStencilViewSpace + dsvIndex * sizeof(D3D12TranslationLayer::DSV)) D3D12TranslationLayer::DSV(&m_pParentDevice->GetContext(), dsvDesc, *m_pResource);
     }
 
     void Resource::InitializeSRVDescFormatAndShaderComponentMapping(_In_ D3DFORMAT d3dFormat, _Out_ D3D12_SHADER_RESOURCE_VIEW_DESC &desc, bool DisableAlphaChannel)
@@ -2125,13 +2315,27 @@ namespace D3D9on12
     HRESULT Resource::Rename(Device& device, CONST D3DDDIARG_RENAME& arg)
     {
         HRESULT hr = S_OK;
+        Check9on12(arg.hCookie != nullptr);
+        if (arg.hCookie == nullptr)
+        {
+            return E_INVALIDARG;
+        }
+
+        if (m_logicalDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            // Textures are renamed through CPU storage handed out by LockAsync rather than a translation layer cookie
+            RenameTexture(device, m_asyncDiscardStorage.TakeCookie(arg.hCookie,
+                [this](UINT subresourceIndex) { return GetAsyncDiscardStorageSize(subresourceIndex); }));
+            return hr;
+        }
+
         Check9on12(arg.SubResourceIndex == 0);
 
         device.GetContext().Rename(m_pResource.get(), reinterpret_cast<D3D12TranslationLayer::Resource*>(arg.hCookie));
         device.GetContext().DeleteRenameCookie(reinterpret_cast<D3D12TranslationLayer::Resource*>(arg.hCookie));
 
         // Discard resources should never be RTVs or DSVs
-        Check9on12(GetRTVBindingTracker().GetBindingIndices().size() == 0 && GetDSVBindingTracker().GetBindingIndices().size() == 0);
+        Check9on12(!GetRTVBindingTracker().IsBound() && !GetDSVBindingTracker().IsBound());
 
         // The rotation mechanism used by rename ensures SRVs are updated before they're used, and future draws will reference the new resource.
 
@@ -2184,6 +2388,7 @@ namespace D3D9on12
         }
 
         Resource* pResource = Resource::GetResourceFromHandle(hResource);
+        pDevice->FlushPendingDraw();
         pDevice->GetContext().GetResourceStateManager().TransitionResource(
             pResource->GetUnderlyingResource(), (D3D12_RESOURCE_STATES)State,
             D3D12TranslationLayer::COMMAND_LIST_TYPE::GRAPHICS,
@@ -2202,6 +2407,7 @@ namespace D3D9on12
         }
 
         Resource* pResource = Resource::GetResourceFromHandle(hResource);
+        pDevice->FlushPendingDraw();
 
         D3D12TranslationLayer::CCurrentResourceState::ExclusiveState ExclusiveState = {};
         ExclusiveState.FenceValue = pDevice->GetContext().GetCommandListID(D3D12TranslationLayer::COMMAND_LIST_TYPE::GRAPHICS);
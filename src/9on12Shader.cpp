@@ -33,6 +33,7 @@ namespace D3D9on12
             RETURN_E_INVALIDARG_AND_CHECK();
         }
 
+        pDevice->FlushPendingDraw();
         pDevice->m_PSDedupe.Release(static_cast<PixelShader*>(pShader));
 
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(S_OK);
@@ -65,6 +66,7 @@ namespace D3D9on12
             RETURN_E_INVALIDARG_AND_CHECK();
         }
 
+        pDevice->FlushPendingDraw();
         pDevice->m_VSDedupe.Release(pShader);
 
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(S_OK);
@@ -219,6 +221,7 @@ namespace D3D9on12
 
         if (derivedShader != m_derivedShaders.end())
         {
+            m_parentDevice.GetDataLogger().AddToCounter(DeviceStatistics::ShaderCacheHits, 1);
             return derivedShader->second;
         }
         else
@@ -394,6 +397,7 @@ namespace D3D9on12
 
         if (derivedShader != m_derivedShaders.end())
         {
+            m_parentDevice.GetDataLogger().AddToCounter(DeviceStatistics::ShaderCacheHits, 1);
             return derivedShader->second;
         }
         else
@@ -452,6 +456,7 @@ namespace D3D9on12
 
         if (derivedShader != m_derivedShaders.end())
         {
+            m_parentDevice.GetDataLogger().AddToCounter(DeviceStatistics::ShaderCacheHits, 1);
             return derivedShader->second;
         }
         else
@@ -30,6 +30,7 @@ namespace D3D9on12
             RETURN_E_INVALIDARG_AND_CHECK();
         }
         
+        pDevice->FlushPendingDraw();
         HRESULT hr = pDevice->Present(*pDevice->m_pUMDPresentArgs, pKMTArgs);
 
         // This pointer becomes invalid after present since it's owned by the runtime
@@ -52,6 +53,7 @@ namespace D3D9on12
             RETURN_E_INVALIDARG_AND_CHECK();
         }
 
+        pDevice->FlushPendingDraw();
         HRESULT hr = pDevice->CloseAndSubmitGraphicsCommandListForPresent(commandsAdded, pSrcSurfaces, numSrcSurfaces, hDestResource, pKMTPresent);
 
         D3D9on12_DDI_ENTRYPOINT_END_AND_RETURN_HR(hr);
@@ -60,6 +62,8 @@ namespace D3D9on12
     HRESULT Device::Present(CONST D3DDDIARG_PRESENT1& PresentArgs, D3DKMT_PRESENT* pKMTArgs)
     {
         Check9on12(PresentArgs.SrcResources == 1);
+        ScopedCounterTimer presentTimer(m_dataLogger, DeviceStatistics::PresentMicroseconds);
+        m_dataLogger.OnPresent();
 
         Resource* pSource = Resource::GetResourceFromHandle(PresentArgs.phSrcResources[0].hResource);
         Resource* pDest = Resource::GetResourceFromHandle(PresentArgs.hDstResource);
@@ -158,6 +162,7 @@ namespace D3D9on12
             }
             
             m_lockedResourceRanges.GetLocked()->clear();
+            TrimStagingReadbackResources();
 
             return hr;
         }
@@ -105,6 +105,8 @@ namespace D3D9on12
 
     void VertexStage::ApplyScissorRect(Device & device)
     {
+        // The scissor isn't deferred to the draw, the held back draw has to be recorded with the previous one
+        device.FlushPendingDraw();
         if (m_scissorTestEnabled)
         {
             device.GetContext().SetScissorRect(0, &m_scissorRect);
@@ -225,6 +227,11 @@ namespace D3D9on12
     {
         HRESULT hr = S_OK;
 
+        if (!m_dirtyFlags.AreVertexStageInputsDirty())
+        {
+            return hr;
+        }
+
         auto& ia = device.GetPipelineState().GetInputAssembly();
         auto& inputLayout = ia.GetInputLayout();
 
@@ -289,6 +289,7 @@ namespace D3D9on12
     void VideoProcessDevice::Blit(CONST D3DDDIARG_VIDEOPROCESSBLT *pBlit)
     {
         assert(m_outputArguments.CurrentFrame[0].pResource);
+        m_pParentDevice->FlushPendingDraw();
 
         // output target rectangle
         static_assert(sizeof(m_outputArguments.D3D12OutputStreamArguments.TargetRectangle) == sizeof(pBlit->TargetRect), "Rects should match");
@@ -695,6 +696,7 @@ namespace D3D9on12
     _Use_decl_annotations_
     void VideoProcessDevice::BlitHD(CONST D3DDDIARG_DXVAHD_VIDEOPROCESSBLTHD *pBlit)
     {
+        m_pParentDevice->FlushPendingDraw();
         SetViewInfo(pBlit->OutputSurface.hResource, pBlit->OutputSurface.SubResourceIndex, &m_outputArguments.CurrentFrame[0]);
 
         if (m_outputArguments.ColorSpaceSet)
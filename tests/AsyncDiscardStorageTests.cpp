@@ -0,0 +1,245 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12AsyncDiscardStorage.h>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+using namespace D3D9on12;
+
+static const size_t cMaxFreeStorage = 2;
+static const UINT cNumSubresources = 4;
+static const UINT cRowPitch = 64;
+static const UINT cNumRows = 4;
+
+typedef AsyncDiscardStoragePool<cMaxFreeStorage> TestStoragePool;
+
+static size_t GetStorageSize(UINT subresourceIndex)
+{
+    // Each mip is half the size of the last, like a texture's subresource footprints
+    return size_t(cRowPitch >> subresourceIndex) * cNumRows;
+}
+
+// Stands in for a texture: Lock/Unlock are what Resource does on the app thread, and Rename what it does on the device
+// thread, with the upload recorded instead of going through UpdateSubresources
+class TestTexture
+{
+public:
+    TestTexture() { m_pool.SetNumSubresources(cNumSubresources); }
+
+    void* Lock(UINT subresourceIndex, BYTE value)
+    {
+        AsyncDiscardStorage *pStorage = m_pool.Open(subresourceIndex, cRowPitch >> subresourceIndex, (cRowPitch >> subresourceIndex) * cNumRows, GetStorageSize(subresourceIndex));
+        std::fill(pStorage->m_data.begin(), pStorage->m_data.end(), value);
+        return pStorage;
+    }
+
+    void Unlock(UINT subresourceIndex) { m_pool.Close(subresourceIndex); }
+
+    template<typename UploadFn>
+    void Rename(void *pCookie, UploadFn&& upload)
+    {
+        std::unique_ptr<AsyncDiscardStorage> pStorage = m_pool.TakeCookie(pCookie, GetStorageSize);
+        upload(*pStorage);
+        m_pool.Recycle(std::move(pStorage));
+    }
+
+    void Rename(void *pCookie)
+    {
+        Rename(pCookie, [this](const AsyncDiscardStorage& storage) { RecordUpload(storage); });
+    }
+
+    void RecordUpload(const AsyncDiscardStorage& storage)
+    {
+        // Every byte has to still be what the lock wrote, or the storage was reused before its rename
+        for (BYTE b : storage.m_data)
+        {
+            if (b != storage.m_data[0])
+            {
+                m_uploads.push_back({ storage.m_subresourceIndex, 0xFFFFFFFF });
+                return;
+            }
+        }
+        m_uploads.push_back({ storage.m_subresourceIndex, storage.m_data[0] });
+    }
+
+    TestStoragePool m_pool;
+    std::vector<std::pair<UINT, UINT>> m_uploads;
+};
+
+static bool TestRecursiveLocksShareStorage()
+{
+    TestTexture texture;
+    void *pCookie = texture.Lock(1, 7);
+    TEST_CHECK(texture.m_pool.GetOpen(1) == pCookie);
+    TEST_CHECK(texture.m_pool.GetOpen(0) == nullptr);
+
+    texture.Unlock(1);
+    TEST_CHECK(texture.m_pool.GetOpen(1) == nullptr);
+
+    texture.Rename(pCookie);
+    TEST_CHECK(texture.m_uploads.size() == 1);
+    TEST_CHECK(texture.m_uploads[0] == std::make_pair(1u, 7u));
+    TEST_CHECK(texture.m_pool.GetNumFreeStorage() == 1);
+    return true;
+}
+
+static bool TestRenameOfAnOpenLockTakesOwnership()
+{
+    // A rename whose lock was never unlocked must leave nothing behind for the destructor to free again
+    TestTexture texture;
+    void *pCookie = texture.Lock(2, 3);
+    texture.Rename(pCookie);
+    TEST_CHECK(texture.m_pool.GetOpen(2) == nullptr);
+    TEST_CHECK(texture.m_uploads.size() == 1);
+
+    // Destroyed while still locked, the pool frees the open storage
+    texture.Lock(0, 1);
+    return true;
+}
+
+static bool TestStorageIsRecycledBySizeUpToTheCap()
+{
+    TestTexture texture;
+    std::vector<void*> cookies;
+    for (UINT i = 0; i < cMaxFreeStorage + 2; i++)
+    {
+        cookies.push_back(texture.Lock(0, BYTE(i)));
+        texture.Unlock(0);
+    }
+    for (void *pCookie : cookies)
+    {
+        texture.Rename(pCookie);
+    }
+    TEST_CHECK(texture.m_pool.GetNumFreeStorage() == cMaxFreeStorage);
+
+    // A lock of another size doesn't take storage it can't use
+    void *pSmaller = texture.Lock(1, 9);
+    texture.Unlock(1);
+    TEST_CHECK(texture.m_pool.GetNumFreeStorage() == cMaxFreeStorage);
+
+    void *pReused = texture.Lock(0, 10);
+    texture.Unlock(0);
+    TEST_CHECK(texture.m_pool.GetNumFreeStorage() == cMaxFreeStorage - 1);
+    TEST_CHECK(std::find(cookies.begin(), cookies.end(), pReused) != cookies.end());
+
+    texture.Rename(pSmaller);
+    texture.Rename(pReused);
+    return true;
+}
+
+static bool TestLocksDontWaitOnARename()
+{
+    // The device thread stalls in the middle of an upload. The app keeps locking the whole time, which only works if
+    // nothing the lock needs is held across the upload.
+    TestTexture texture;
+    void *pFirstCookie = texture.Lock(0, 1);
+    texture.Unlock(0);
+
+    std::promise<void> uploadStarted;
+    std::promise<void> finishUpload;
+    std::shared_future<void> finishUploadFuture = finishUpload.get_future().share();
+    std::thread deviceThread([&]()
+    {
+        texture.Rename(pFirstCookie, [&](const AsyncDiscardStorage& storage)
+        {
+            uploadStarted.set_value();
+            finishUploadFuture.wait();
+            texture.RecordUpload(storage);
+        });
+    });
+    uploadStarted.get_future().wait();
+
+    std::vector<void*> cookies;
+    std::future<void> appThread = std::async(std::launch::async, [&]()
+    {
+        for (UINT i = 0; i < 16; i++)
+        {
+            cookies.push_back(texture.Lock(i % cNumSubresources, BYTE(2 + i)));
+            texture.Unlock(i % cNumSubresources);
+        }
+    });
+    const bool appFinishedDuringUpload = appThread.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+
+    finishUpload.set_value();
+    deviceThread.join();
+    appThread.wait();
+    TEST_CHECK(appFinishedDuringUpload);
+
+    // Storage that's waiting on its rename is never handed out again
+    std::vector<void*> sorted = cookies;
+    std::sort(sorted.begin(), sorted.end());
+    TEST_CHECK(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+    for (void *pCookie : cookies)
+    {
+        texture.Rename(pCookie);
+    }
+    TEST_CHECK(texture.m_uploads.size() == 17);
+    TEST_CHECK(texture.m_uploads[0] == std::make_pair(0u, 1u));
+    for (UINT i = 0; i < 16; i++)
+    {
+        TEST_CHECK(texture.m_uploads[1 + i] == std::make_pair(i % cNumSubresources, 2u + i));
+    }
+    return true;
+}
+
+static bool TestConcurrentRenamesUploadInLockOrder()
+{
+    // The app thread locks and queues the renames like the runtime's command stream while the device thread consumes
+    // them. Each upload must see exactly what its lock wrote, in the order the locks were made.
+    static const UINT cNumLocks = 2000;
+    TestTexture texture;
+    std::mutex queueLock;
+    std::condition_variable queueChanged;
+    std::deque<void*> renames;
+
+    std::thread deviceThread([&]()
+    {
+        for (UINT i = 0; i < cNumLocks; i++)
+        {
+            void *pCookie;
+            {
+                std::unique_lock<std::mutex> lock(queueLock);
+                queueChanged.wait(lock, [&]() { return !renames.empty(); });
+                pCookie = renames.front();
+                renames.pop_front();
+            }
+            texture.Rename(pCookie);
+        }
+    });
+
+    std::mt19937 random(34);
+    std::vector<std::pair<UINT, UINT>> expectedUploads;
+    for (UINT i = 0; i < cNumLocks; i++)
+    {
+        const UINT subresourceIndex = random() % cNumSubresources;
+        const BYTE value = BYTE(i % 251);
+        void *pCookie = texture.Lock(subresourceIndex, value);
+        texture.Unlock(subresourceIndex);
+        expectedUploads.push_back({ subresourceIndex, value });
+
+        std::lock_guard<std::mutex> lock(queueLock);
+        renames.push_back(pCookie);
+        queueChanged.notify_one();
+    }
+    deviceThread.join();
+
+    TEST_CHECK(texture.m_uploads == expectedUploads);
+    TEST_CHECK(texture.m_pool.GetNumFreeStorage() <= cMaxFreeStorage);
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "RecursiveLocksShareStorage", TestRecursiveLocksShareStorage },
+        { "RenameOfAnOpenLockTakesOwnership", TestRenameOfAnOpenLockTakesOwnership },
+        { "StorageIsRecycledBySizeUpToTheCap", TestStorageIsRecycledBySizeUpToTheCap },
+        { "LocksDontWaitOnARename", TestLocksDontWaitOnARename },
+        { "ConcurrentRenamesUploadInLockOrder", TestConcurrentRenamesUploadInLockOrder },
+    };
+    return RunTests(cTests);
+}
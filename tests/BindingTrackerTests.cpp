@@ -0,0 +1,104 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12BindingTracker.h>
+
+using namespace D3D9on12;
+
+// The SRV, RTV and VB trackers use the sampler stage, render target and stream counts, the DSV and IB ones one slot
+static const UINT cNumSlots = 20;
+
+static bool TestBindAndUnbind()
+{
+    BindingTracker<cNumSlots> tracker;
+    TEST_CHECK(!tracker.IsBound());
+    TEST_CHECK(tracker.GetBindingCount() == 0);
+
+    tracker.Bind(3);
+    tracker.Bind(17);
+    TEST_CHECK(tracker.IsBound());
+    TEST_CHECK(tracker.GetBindingMask() == (BIT(3) | BIT(17)));
+    TEST_CHECK(tracker.GetBindingCount() == 2);
+    TEST_CHECK(tracker.GetFirstBindingIndex() == 3);
+
+    // Binding a slot twice is the same as binding it once, the runtime can rebind a resource to the slot it's in
+    tracker.Bind(3);
+    TEST_CHECK(tracker.GetBindingCount() == 2);
+
+    tracker.Unbind(3);
+    TEST_CHECK(tracker.GetFirstBindingIndex() == 17);
+    tracker.Unbind(17);
+    TEST_CHECK(!tracker.IsBound());
+
+    // Unbinding a slot that isn't bound doesn't touch the others
+    tracker.Bind(0);
+    tracker.Unbind(5);
+    TEST_CHECK(tracker.GetBindingMask() == BIT(0));
+    return true;
+}
+
+static bool TestSingleSlot()
+{
+    BindingTracker<1> tracker;
+    tracker.Bind(0);
+    TEST_CHECK(tracker.IsBound() && tracker.GetBindingCount() == 1 && tracker.GetFirstBindingIndex() == 0);
+    tracker.Unbind(0);
+    TEST_CHECK(!tracker.IsBound());
+    return true;
+}
+
+// Resource teardown unbinds the first bound slot until none are left, which has to visit every slot exactly once
+static bool TestRandomizedAgainstSlotList()
+{
+    std::mt19937 random(32);
+    for (UINT sequence = 0; sequence < 100; sequence++)
+    {
+        BindingTracker<cNumSlots> tracker;
+        std::vector<bool> isBound(cNumSlots, false);
+        for (UINT step = 0; step < 100; step++)
+        {
+            const UINT slot = random() % cNumSlots;
+            if (random() % 2)
+            {
+                tracker.Bind(slot);
+                isBound[slot] = true;
+            }
+            else
+            {
+                tracker.Unbind(slot);
+                isBound[slot] = false;
+            }
+
+            UINT expectedMask = 0;
+            for (UINT i = 0; i < cNumSlots; i++)
+            {
+                expectedMask |= isBound[i] ? BIT(i) : 0;
+            }
+            TEST_CHECK(tracker.GetBindingMask() == expectedMask);
+            TEST_CHECK(tracker.GetBindingCount() == UINT(std::count(isBound.begin(), isBound.end(), true)));
+        }
+
+        std::vector<UINT> unboundSlots;
+        while (tracker.IsBound())
+        {
+            const UINT slot = tracker.GetFirstBindingIndex();
+            TEST_CHECK(isBound[slot]);
+            unboundSlots.push_back(slot);
+            tracker.Unbind(slot);
+        }
+        TEST_CHECK(unboundSlots.size() == UINT(std::count(isBound.begin(), isBound.end(), true)));
+        TEST_CHECK(std::is_sorted(unboundSlots.begin(), unboundSlots.end()));
+    }
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "BindAndUnbind", TestBindAndUnbind },
+        { "SingleSlot", TestSingleSlot },
+        { "RandomizedAgainstSlotList", TestRandomizedAgainstSlotList },
+    };
+    return RunTests(cTests);
+}
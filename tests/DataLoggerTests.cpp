@@ -0,0 +1,187 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12DataLogger.h>
+
+using namespace D3D9on12;
+
+// Queries report the difference between the snapshots taken at Begin and End, the same way Query::FillStatisticsData does
+static UINT64 CounterDelta(const DeviceStatistics &begin, const DeviceStatistics &end, DeviceStatistics::DeviceCounter counter)
+{
+    return end.m_counters[counter] - begin.m_counters[counter];
+}
+
+static bool TestCountersOnlyAccumulateWhileQueried()
+{
+    DataLogger logger;
+    TEST_CHECK(!logger.IsCountingEnabled());
+
+    logger.AddToCounter(DeviceStatistics::Flushes, 5);
+    TEST_CHECK(logger.GetStatistics().m_counters[DeviceStatistics::Flushes] == 0);
+
+    logger.BeginCounterQuery();
+    const DeviceStatistics begin = logger.GetStatistics();
+    logger.AddToCounter(DeviceStatistics::Flushes, 2);
+    logger.AddToCounter(DeviceStatistics::UploadHeapBytes, 4096);
+    logger.AddShaderData(D3D10_SB_VERTEX_SHADER, 10, 2);
+    const DeviceStatistics end = logger.GetStatistics();
+    logger.EndCounterQuery();
+
+    TEST_CHECK(CounterDelta(begin, end, DeviceStatistics::Flushes) == 2);
+    TEST_CHECK(CounterDelta(begin, end, DeviceStatistics::UploadHeapBytes) == 4096);
+    TEST_CHECK(CounterDelta(begin, end, DeviceStatistics::ShaderConversions) == 1);
+    TEST_CHECK(CounterDelta(begin, end, DeviceStatistics::ReadbackWaits) == 0);
+
+    // Nothing is counted between queries, so a later query doesn't see work done in between
+    logger.AddToCounter(DeviceStatistics::Flushes, 7);
+    TEST_CHECK(logger.GetStatistics().m_counters[DeviceStatistics::Flushes] == 2);
+    return true;
+}
+
+static bool TestOverlappingCounterQueries()
+{
+    DataLogger logger;
+    logger.BeginCounterQuery();
+    const DeviceStatistics outerBegin = logger.GetStatistics();
+    logger.AddToCounter(DeviceStatistics::ReadbackWaits, 1);
+
+    logger.BeginCounterQuery();
+    const DeviceStatistics innerBegin = logger.GetStatistics();
+    logger.AddToCounter(DeviceStatistics::ReadbackWaits, 1);
+    const DeviceStatistics innerEnd = logger.GetStatistics();
+    logger.EndCounterQuery();
+
+    // Ending the inner query must leave counting on for the outer one
+    TEST_CHECK(logger.IsCountingEnabled());
+    logger.AddToCounter(DeviceStatistics::ReadbackWaits, 1);
+    const DeviceStatistics outerEnd = logger.GetStatistics();
+    logger.EndCounterQuery();
+    TEST_CHECK(!logger.IsCountingEnabled());
+
+    TEST_CHECK(CounterDelta(innerBegin, innerEnd, DeviceStatistics::ReadbackWaits) == 1);
+    TEST_CHECK(CounterDelta(outerBegin, outerEnd, DeviceStatistics::ReadbackWaits) == 3);
+    return true;
+}
+
+static bool TestScopedCounterTimer()
+{
+    DataLogger logger;
+    {
+        ScopedCounterTimer timer(logger, DeviceStatistics::PresentMicroseconds);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    TEST_CHECK(logger.GetStatistics().m_counters[DeviceStatistics::PresentMicroseconds] == 0);
+
+    logger.BeginCounterQuery();
+    {
+        ScopedCounterTimer timer(logger, DeviceStatistics::PresentMicroseconds);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    {
+        ScopedCounterTimer timer(logger, DeviceStatistics::LockStallMicroseconds, false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    TEST_CHECK(logger.GetStatistics().m_counters[DeviceStatistics::PresentMicroseconds] >= 2000);
+    TEST_CHECK(logger.GetStatistics().m_counters[DeviceStatistics::LockStallMicroseconds] == 0);
+    logger.EndCounterQuery();
+    return true;
+}
+
+// DDI calls come in on any thread and are counted for the process while any device has a counter query active
+static bool TestDDICallsAreCountedAcrossThreads()
+{
+    DataLogger idleLogger;
+    DataLogger queriedLogger;
+    const UINT64 before = queriedLogger.GetStatistics().m_counters[DeviceStatistics::DDICalls];
+    DataLogger::CountDDICall();
+    TEST_CHECK(queriedLogger.GetStatistics().m_counters[DeviceStatistics::DDICalls] == before);
+
+    queriedLogger.BeginCounterQuery();
+    const UINT cThreads = 4;
+    const UINT cCallsPerThread = 10000;
+    std::vector<std::thread> threads;
+    for (UINT i = 0; i < cThreads; i++)
+    {
+        threads.emplace_back([] { for (UINT call = 0; call < cCallsPerThread; call++) { DataLogger::CountDDICall(); } });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    const DeviceStatistics end = queriedLogger.GetStatistics();
+    queriedLogger.EndCounterQuery();
+
+    TEST_CHECK(end.m_counters[DeviceStatistics::DDICalls] - before == cThreads * cCallsPerThread);
+    TEST_CHECK(idleLogger.GetStatistics().m_counters[DeviceStatistics::DDICalls] == end.m_counters[DeviceStatistics::DDICalls]);
+    return true;
+}
+
+static bool TestPresentResetsPerFrameStatistics()
+{
+    DataLogger logger;
+    logger.AddDraw(D3DPT_TRIANGLELIST, 10, 2);
+    logger.AddDraw(D3DPT_TRIANGLEFAN, 3, 1);
+    logger.AddDraw(D3DPT_LINELIST, 100, 1);
+    logger.AddResource(D3DRTYPE_TEXTURE, 1024, false);
+    logger.AddUploadedBytes(D3DRTYPE_VERTEXBUFFER, 256);
+
+    DeviceStatistics statistics = logger.GetStatistics();
+    TEST_CHECK(statistics.m_renderedTrianglesSincePresent == 23);
+    TEST_CHECK(statistics.m_resources[D3DRTYPE_TEXTURE].m_videoMemoryCreatesSincePresent == 1);
+    TEST_CHECK(statistics.m_resources[D3DRTYPE_VERTEXBUFFER].m_bytesUploadedSincePresent == 256);
+
+    logger.OnPresent();
+    statistics = logger.GetStatistics();
+    TEST_CHECK(statistics.m_renderedTrianglesSincePresent == 0);
+    TEST_CHECK(statistics.m_resources[D3DRTYPE_TEXTURE].m_videoMemoryCreatesSincePresent == 0);
+    TEST_CHECK(statistics.m_resources[D3DRTYPE_VERTEXBUFFER].m_bytesUploadedSincePresent == 0);
+
+    // Live resources outlast the frame
+    TEST_CHECK(statistics.m_resources[D3DRTYPE_TEXTURE].m_liveCount == 1);
+    TEST_CHECK(statistics.m_resources[D3DRTYPE_TEXTURE].m_videoMemoryBytes == 1024);
+    return true;
+}
+
+static bool TestResourceAccounting()
+{
+    DataLogger logger;
+    logger.AddResource(D3DRTYPE_VERTEXBUFFER, 100, false);
+    logger.AddResource(D3DRTYPE_VERTEXBUFFER, 40, true);
+    logger.AddResource(D3DRTYPE_INDEXBUFFER, 60, false);
+
+    const DeviceStatistics::ResourceTypeStatistics &vertexBuffers = logger.GetStatistics().m_resources[D3DRTYPE_VERTEXBUFFER];
+    TEST_CHECK(vertexBuffers.m_liveCount == 2 && vertexBuffers.m_liveBytes == 140);
+    TEST_CHECK(vertexBuffers.m_videoMemoryCount == 1 && vertexBuffers.m_videoMemoryBytes == 100);
+
+    // System memory resources never count against video memory, on the way out either
+    logger.RemoveResource(D3DRTYPE_VERTEXBUFFER, 40, true);
+    DeviceStatistics statistics = logger.GetStatistics();
+    TEST_CHECK(statistics.m_resources[D3DRTYPE_VERTEXBUFFER].m_liveCount == 1 && statistics.m_resources[D3DRTYPE_VERTEXBUFFER].m_liveBytes == 100);
+    TEST_CHECK(statistics.m_resources[D3DRTYPE_VERTEXBUFFER].m_videoMemoryCount == 1 && statistics.m_resources[D3DRTYPE_VERTEXBUFFER].m_videoMemoryBytes == 100);
+
+    logger.RemoveResource(D3DRTYPE_VERTEXBUFFER, 100, false);
+    logger.RemoveResource(D3DRTYPE_INDEXBUFFER, 60, false);
+    statistics = logger.GetStatistics();
+    for (const DeviceStatistics::ResourceTypeStatistics &stats : statistics.m_resources)
+    {
+        TEST_CHECK(stats.m_liveCount == 0 && stats.m_liveBytes == 0 && stats.m_videoMemoryCount == 0 && stats.m_videoMemoryBytes == 0);
+    }
+
+    // Creations since the last present aren't undone by destruction
+    TEST_CHECK(statistics.m_resources[D3DRTYPE_VERTEXBUFFER].m_videoMemoryCreatesSincePresent == 1);
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "CountersOnlyAccumulateWhileQueried", TestCountersOnlyAccumulateWhileQueried },
+        { "OverlappingCounterQueries", TestOverlappingCounterQueries },
+        { "ScopedCounterTimer", TestScopedCounterTimer },
+        { "DDICallsAreCountedAcrossThreads", TestDDICallsAreCountedAcrossThreads },
+        { "PresentResetsPerFrameStatistics", TestPresentResetsPerFrameStatistics },
+        { "ResourceAccounting", TestResourceAccounting },
+    };
+    return RunTests(cTests);
+}
@@ -0,0 +1,220 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12IndexBufferShadow.h>
+#include <memory>
+
+using namespace D3D9on12;
+
+static const UINT64 cNoMemoryLimit = ~0ull;
+
+static std::vector<BYTE> RandomBytes(std::mt19937& random, size_t size)
+{
+    std::vector<BYTE> bytes(size);
+    for (BYTE& byte : bytes)
+    {
+        byte = static_cast<BYTE>(random());
+    }
+    return bytes;
+}
+
+static bool Matches(const IndexBufferShadow& shadow, const std::vector<BYTE>& reference)
+{
+    TEST_CHECK(shadow.IsValid());
+    TEST_CHECK(memcmp(shadow.GetData(), reference.data(), reference.size()) == 0);
+    return true;
+}
+
+// Applies a buffer copy to the reference the way the GPU would, clipped to both buffers
+static void CopyReference(std::vector<BYTE>& destination, UINT destinationOffset, const std::vector<BYTE>& source, UINT sourceStart, UINT sourceEnd)
+{
+    sourceEnd = min(sourceEnd, static_cast<UINT>(source.size()));
+    for (UINT i = sourceStart; i < sourceEnd && destinationOffset + (i - sourceStart) < destination.size(); i++)
+    {
+        destination[destinationOffset + (i - sourceStart)] = source[i];
+    }
+}
+
+// The reference stands in for the index buffer's GPU memory, locks hand out pointers into it
+static bool TestLocksAndCopiesKeepTheShadowCurrent()
+{
+    const UINT cSize = 256;
+    std::mt19937 random(7);
+    std::atomic<UINT64> memoryUsage { 0 };
+
+    std::vector<BYTE> reference = RandomBytes(random, cSize);
+    IndexBufferShadow shadow;
+    shadow.Fill(memoryUsage, cNoMemoryLimit, reference.data(), cSize, false);
+    TEST_CHECK(Matches(shadow, reference));
+
+    std::vector<BYTE> otherReference = RandomBytes(random, cSize / 2);
+    IndexBufferShadow otherShadow;
+    otherShadow.Fill(memoryUsage, cNoMemoryLimit, otherReference.data(), otherReference.size(), false);
+
+    for (UINT i = 0; i < 2000; i++)
+    {
+        const UINT start = random() % cSize;
+        const UINT end = start + 1 + random() % (cSize - start);
+        switch (random() % 4)
+        {
+        case 0:
+        {
+            // Box lock, writing part of the box
+            shadow.Lock(reference.data() + start, false, false);
+            const UINT written = random() % (end - start + 1);
+            const std::vector<BYTE> data = RandomBytes(random, written);
+            memcpy(reference.data() + start, data.data(), written);
+            shadow.Unlock(true, start, end);
+            break;
+        }
+        case 1:
+        {
+            // Whole buffer lock
+            shadow.Lock(reference.data(), false, false);
+            const std::vector<BYTE> data = RandomBytes(random, end - start);
+            memcpy(reference.data() + start, data.data(), data.size());
+            shadow.Unlock(true, 0, cSize);
+            break;
+        }
+        case 2:
+        {
+            // Copy from system memory, which can overrun the end of either buffer
+            const std::vector<BYTE> source = RandomBytes(random, cSize);
+            const UINT destinationOffset = random() % cSize;
+            const UINT sourceEnd = end + random() % 8;
+            shadow.Copy(destinationOffset, source.data(), cSize, start, sourceEnd, true);
+            CopyReference(reference, destinationOffset, source, start, sourceEnd);
+            break;
+        }
+        case 3:
+        {
+            // Copy from another shadowed index buffer
+            const UINT sourceStart = start % otherReference.size();
+            const UINT sourceEnd = sourceStart + 1 + random() % (otherReference.size() - sourceStart);
+            const UINT destinationOffset = random() % cSize;
+            shadow.Copy(destinationOffset, otherShadow.GetData(), static_cast<UINT>(otherReference.size()), sourceStart, sourceEnd, true);
+            CopyReference(reference, destinationOffset, otherReference, sourceStart, sourceEnd);
+            break;
+        }
+        }
+        TEST_CHECK(Matches(shadow, reference));
+    }
+    return true;
+}
+
+static bool TestUnmirrorableWritesInvalidate()
+{
+    const UINT cSize = 64;
+    std::mt19937 random(11);
+    std::atomic<UINT64> memoryUsage { 0 };
+    std::vector<BYTE> reference = RandomBytes(random, cSize);
+    IndexBufferShadow shadow;
+
+    // Recursive lock: the inner lock's box replaces the outer one's, so neither is mirrored
+    shadow.Fill(memoryUsage, cNoMemoryLimit, reference.data(), cSize, false);
+    shadow.Lock(reference.data(), false, false);
+    shadow.Lock(reference.data() + 8, false, true);
+    reference[20] ^= 0xff;
+    shadow.Unlock(false, 8, 16);
+    shadow.Unlock(true, 0, cSize);
+    TEST_CHECK(!shadow.IsValid());
+    TEST_CHECK(shadow.GetData() == nullptr);
+
+    // Async lock
+    shadow.Fill(memoryUsage, cNoMemoryLimit, reference.data(), cSize, false);
+    TEST_CHECK(Matches(shadow, reference));
+    shadow.Lock(reference.data(), true, false);
+    TEST_CHECK(!shadow.IsValid());
+    shadow.Unlock(true, 0, cSize);
+    TEST_CHECK(!shadow.IsValid());
+
+    // Filled while a lock was open, what the app writes before unlocking isn't seen
+    shadow.Fill(memoryUsage, cNoMemoryLimit, reference.data(), cSize, true);
+    TEST_CHECK(!shadow.IsValid());
+    shadow.Unlock(true, 0, cSize);
+    TEST_CHECK(!shadow.IsValid());
+
+    // Copies from memory the CPU can't see and texture copies
+    shadow.Fill(memoryUsage, cNoMemoryLimit, reference.data(), cSize, false);
+    shadow.Copy(0, nullptr, cSize, 0, cSize, true);
+    TEST_CHECK(!shadow.IsValid());
+    shadow.Fill(memoryUsage, cNoMemoryLimit, reference.data(), cSize, false);
+    shadow.Copy(0, reference.data(), cSize, 0, cSize, false);
+    TEST_CHECK(!shadow.IsValid());
+
+    // Invalidated shadows don't mirror later writes either, the next fill reads the buffer back
+    shadow.Lock(reference.data(), false, false);
+    reference[0] ^= 0xff;
+    shadow.Unlock(true, 0, cSize);
+    TEST_CHECK(!shadow.IsValid());
+    shadow.Fill(memoryUsage, cNoMemoryLimit, reference.data(), cSize, false);
+    TEST_CHECK(Matches(shadow, reference));
+    TEST_CHECK(memoryUsage == cSize);
+    return true;
+}
+
+static bool TestMemoryLimitFallsBackToReadback()
+{
+    std::atomic<UINT64> memoryUsage { 0 };
+    const UINT64 cMemoryLimit = 300;
+    const std::vector<BYTE> data(200, 1);
+    {
+        IndexBufferShadow first;
+        first.Fill(memoryUsage, cMemoryLimit, data.data(), data.size(), false);
+        TEST_CHECK(first.IsValid());
+        TEST_CHECK(memoryUsage == 200);
+
+        // Refilling doesn't count the shadow twice
+        first.Fill(memoryUsage, cMemoryLimit, data.data(), data.size(), false);
+        TEST_CHECK(memoryUsage == 200);
+
+        IndexBufferShadow second;
+        second.Fill(memoryUsage, cMemoryLimit, data.data(), data.size(), false);
+        TEST_CHECK(!second.IsValid());
+        TEST_CHECK(second.GetData() == nullptr);
+        TEST_CHECK(memoryUsage == 200);
+    }
+    TEST_CHECK(memoryUsage == 0);
+
+    // Concurrent fills can't overshoot the limit together
+    std::vector<std::unique_ptr<IndexBufferShadow>> shadows;
+    for (UINT i = 0; i < 8; i++)
+    {
+        shadows.push_back(std::make_unique<IndexBufferShadow>());
+    }
+    std::vector<std::thread> threads;
+    for (auto& pShadow : shadows)
+    {
+        threads.emplace_back([&memoryUsage, &pShadow]()
+        {
+            const std::vector<BYTE> threadData(100, 2);
+            pShadow->Fill(memoryUsage, 350, threadData.data(), threadData.size(), false);
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    UINT validShadows = 0;
+    for (auto& pShadow : shadows)
+    {
+        validShadows += pShadow->IsValid() ? 1 : 0;
+    }
+    TEST_CHECK(validShadows == 3);
+    TEST_CHECK(memoryUsage == 300);
+    shadows.clear();
+    TEST_CHECK(memoryUsage == 0);
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "LocksAndCopiesKeepTheShadowCurrent", TestLocksAndCopiesKeepTheShadowCurrent },
+        { "UnmirrorableWritesInvalidate", TestUnmirrorableWritesInvalidate },
+        { "MemoryLimitFallsBackToReadback", TestMemoryLimitFallsBackToReadback },
+    };
+    return RunTests(cTests);
+}
@@ -0,0 +1,112 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12LockedRangeSet.h>
+
+using namespace D3D9on12;
+
+// Linear reference: one flag per byte of a small buffer
+class ReferenceRangeSet
+{
+public:
+    explicit ReferenceRangeSet(UINT size) : m_locked(size, false) {}
+
+    bool Overlaps(UINT start, UINT end) const
+    {
+        for (UINT i = start; i < end; i++)
+        {
+            if (m_locked[i])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Insert(UINT start, UINT end) { std::fill(m_locked.begin() + start, m_locked.begin() + end, true); }
+    void Clear() { std::fill(m_locked.begin(), m_locked.end(), false); }
+
+private:
+    std::vector<bool> m_locked;
+};
+
+static bool CompareAllRanges(const LockedRangeSet& set, const ReferenceRangeSet& reference, UINT size)
+{
+    for (UINT start = 0; start <= size; start++)
+    {
+        for (UINT end = start; end <= size; end++)
+        {
+            TEST_CHECK(set.Overlaps(start, end) == reference.Overlaps(start, end));
+        }
+    }
+    return true;
+}
+
+// Touching ranges are merged, so queries right at the seams must still see both sides
+static bool TestAdjacentRanges()
+{
+    LockedRangeSet set;
+    set.Insert(10, 20);
+    set.Insert(30, 40);
+    set.Insert(20, 30);
+    set.Insert(0, 10);
+
+    TEST_CHECK(set.Overlaps(0, 1));
+    TEST_CHECK(set.Overlaps(19, 21));
+    TEST_CHECK(set.Overlaps(39, 40));
+    TEST_CHECK(!set.Overlaps(40, 41));
+    TEST_CHECK(!set.Overlaps(40, 100));
+    TEST_CHECK(!set.Overlaps(5, 5));
+
+    set.Clear();
+    TEST_CHECK(!set.Overlaps(0, 100));
+    return true;
+}
+
+// Follows the way Lock uses the set: a range that doesn't overlap is added, one that does starts a new frame of ranges
+static bool TestRandomizedAgainstReference()
+{
+    const UINT cBufferSize = 96;
+    std::mt19937 random(9012);
+    std::uniform_int_distribution<UINT> offset(0, cBufferSize);
+
+    for (UINT iteration = 0; iteration < 200; iteration++)
+    {
+        LockedRangeSet set;
+        ReferenceRangeSet reference(cBufferSize);
+        for (UINT lock = 0; lock < 40; lock++)
+        {
+            UINT start = offset(random);
+            UINT end = offset(random);
+            if (start > end)
+            {
+                std::swap(start, end);
+            }
+
+            const bool overlaps = set.Overlaps(start, end);
+            TEST_CHECK(overlaps == reference.Overlaps(start, end));
+            if (overlaps)
+            {
+                set.Clear();
+                reference.Clear();
+            }
+            set.Insert(start, end);
+            reference.Insert(start, end);
+        }
+        if (!CompareAllRanges(set, reference, cBufferSize))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "AdjacentRanges", TestAdjacentRanges },
+        { "RandomizedAgainstReference", TestRandomizedAgainstReference },
+    };
+    return RunTests(cTests);
+}
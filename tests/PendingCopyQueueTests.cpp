@@ -0,0 +1,162 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12PendingCopyQueue.h>
+
+using namespace D3D9on12;
+
+static const size_t cMaxPendingCopies = 4;
+static const UINT cNumSubresources = 8;
+
+// Stands in for Resource::PendingSystemMemoryCopy, completing it writes m_value to its destination subresources
+struct TestCopy
+{
+    UINT m_destinationSubresourceIndex;
+    UINT m_numSubresources;
+    bool m_dimensionsCoverEntireResource;
+    UINT m_value;
+};
+
+typedef PendingCopyQueue<TestCopy, cMaxPendingCopies> TestCopyQueue;
+
+class SystemMemory
+{
+public:
+    void Complete(const TestCopy& copy)
+    {
+        for (UINT i = 0; i < copy.m_numSubresources; i++)
+        {
+            m_subresources[copy.m_destinationSubresourceIndex + i] = copy.m_value;
+        }
+        m_completed.push_back(copy.m_value);
+    }
+
+    UINT m_subresources[cNumSubresources] = {};
+    std::vector<UINT> m_completed;
+};
+
+static void Push(TestCopyQueue& queue, SystemMemory& memory, std::vector<UINT>& discarded, const TestCopy& copy)
+{
+    queue.DiscardSuperseded(copy, [&discarded](TestCopy& supersededCopy) { discarded.push_back(supersededCopy.m_value); });
+    queue.Push(TestCopy(copy), [&memory](TestCopy& oldestCopy) { memory.Complete(oldestCopy); });
+}
+
+static void Resolve(TestCopyQueue& queue, SystemMemory& memory)
+{
+    queue.Resolve([&memory](TestCopy& copy) { memory.Complete(copy); });
+}
+
+static bool TestCopiesCompleteInRecordedOrder()
+{
+    TestCopyQueue queue;
+    SystemMemory memory;
+    std::vector<UINT> discarded;
+    TEST_CHECK(queue.IsEmpty());
+
+    // Partial copies into the same subresource never supersede each other
+    Push(queue, memory, discarded, { 2, 1, false, 1 });
+    Push(queue, memory, discarded, { 2, 1, false, 2 });
+    Push(queue, memory, discarded, { 1, 2, false, 3 });
+    TEST_CHECK(!queue.IsEmpty());
+    TEST_CHECK(memory.m_completed.empty());
+
+    Resolve(queue, memory);
+    TEST_CHECK(queue.IsEmpty());
+    TEST_CHECK(discarded.empty());
+    TEST_CHECK((memory.m_completed == std::vector<UINT>{ 1, 2, 3 }));
+    TEST_CHECK(memory.m_subresources[1] == 3 && memory.m_subresources[2] == 3);
+    return true;
+}
+
+static bool TestFullCopiesDiscardTheCopiesTheyOverwrite()
+{
+    TestCopyQueue queue;
+    SystemMemory memory;
+    std::vector<UINT> discarded;
+
+    Push(queue, memory, discarded, { 0, 1, true, 1 });
+    Push(queue, memory, discarded, { 1, 2, true, 2 });
+    Push(queue, memory, discarded, { 0, 1, false, 3 });
+
+    // A partial copy doesn't overwrite anything completely
+    Push(queue, memory, discarded, { 0, 4, false, 4 });
+    TEST_CHECK(discarded.empty());
+
+    // Only copies whose subresources all lie inside the new copy's are discarded
+    Push(queue, memory, discarded, { 0, 2, true, 5 });
+    TEST_CHECK((discarded == std::vector<UINT>{ 1, 3 }));
+    TEST_CHECK(queue.Size() == 3);
+
+    Resolve(queue, memory);
+    TEST_CHECK((memory.m_completed == std::vector<UINT>{ 2, 4, 5 }));
+    TEST_CHECK(memory.m_subresources[0] == 5 && memory.m_subresources[1] == 5 && memory.m_subresources[2] == 4 && memory.m_subresources[3] == 4);
+    return true;
+}
+
+static bool TestOldestCopiesCompleteAtTheCap()
+{
+    TestCopyQueue queue;
+    SystemMemory memory;
+    std::vector<UINT> discarded;
+    for (UINT i = 1; i <= cMaxPendingCopies; i++)
+    {
+        Push(queue, memory, discarded, { i, 1, false, i });
+    }
+    TEST_CHECK(memory.m_completed.empty());
+    TEST_CHECK(queue.Size() == cMaxPendingCopies);
+
+    Push(queue, memory, discarded, { 0, 1, false, 5 });
+    Push(queue, memory, discarded, { 0, 1, false, 6 });
+    TEST_CHECK((memory.m_completed == std::vector<UINT>{ 1, 2 }));
+    TEST_CHECK(queue.Size() == cMaxPendingCopies);
+
+    Resolve(queue, memory);
+    TEST_CHECK((memory.m_completed == std::vector<UINT>{ 1, 2, 3, 4, 5, 6 }));
+    return true;
+}
+
+// Deferring, discarding and completing early must leave the system memory as if every copy was done when recorded
+static bool TestRandomizedAgainstImmediateCopies()
+{
+    std::mt19937 random(3);
+    for (UINT iteration = 0; iteration < 200; iteration++)
+    {
+        TestCopyQueue queue;
+        SystemMemory memory;
+        SystemMemory reference;
+        std::vector<UINT> discarded;
+        for (UINT value = 1; value <= 100; value++)
+        {
+            const UINT destination = random() % cNumSubresources;
+            const TestCopy copy = { destination, 1 + static_cast<UINT>(random() % (cNumSubresources - destination)), (random() % 2) == 0, value };
+            Push(queue, memory, discarded, copy);
+            reference.Complete(copy);
+            TEST_CHECK(queue.Size() <= cMaxPendingCopies);
+
+            if (random() % 10 == 0)
+            {
+                Resolve(queue, memory);
+                TEST_CHECK(memcmp(memory.m_subresources, reference.m_subresources, sizeof(reference.m_subresources)) == 0);
+            }
+        }
+        Resolve(queue, memory);
+        TEST_CHECK(memcmp(memory.m_subresources, reference.m_subresources, sizeof(reference.m_subresources)) == 0);
+
+        // Every copy is either completed or discarded, exactly once
+        TEST_CHECK(memory.m_completed.size() + discarded.size() == 100);
+        TEST_CHECK(std::is_sorted(memory.m_completed.begin(), memory.m_completed.end()));
+    }
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "CopiesCompleteInRecordedOrder", TestCopiesCompleteInRecordedOrder },
+        { "FullCopiesDiscardTheCopiesTheyOverwrite", TestFullCopiesDiscardTheCopiesTheyOverwrite },
+        { "OldestCopiesCompleteAtTheCap", TestOldestCopiesCompleteAtTheCap },
+        { "RandomizedAgainstImmediateCopies", TestRandomizedAgainstImmediateCopies },
+    };
+    return RunTests(cTests);
+}
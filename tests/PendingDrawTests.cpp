@@ -0,0 +1,497 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12PendingDraw.h>
+
+using namespace D3D9on12;
+
+// What reached the command list: either a draw, expanded to the vertex data it reads, or any other command
+struct RecordedCommand
+{
+    bool m_isDraw;
+    UINT m_state;
+    D3DPRIMITIVETYPE m_primitiveType;
+    std::vector<UINT> m_vertices;
+};
+
+// Stands in for the translation layer's immediate context, draws read from whatever batches are bound when they're recorded
+class RecordingContext
+{
+public:
+    void DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex, UINT startInstance)
+    {
+        Check9on12(instanceCount == 1 && startInstance == 0);
+        const std::vector<UINT>& vertexBatch = m_vertexBatches[m_boundVertexBatch - 1];
+        Check9on12(startVertex + vertexCount <= vertexBatch.size());
+        m_commands.push_back({ true, m_state, m_primitiveType, std::vector<UINT>(vertexBatch.begin() + startVertex, vertexBatch.begin() + startVertex + vertexCount) });
+        m_draws++;
+    }
+
+    void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance)
+    {
+        Check9on12(instanceCount == 1 && startInstance == 0);
+        const std::vector<UINT>& vertexBatch = m_vertexBatches[m_boundVertexBatch - 1];
+        const std::vector<UINT>& indexBatch = m_indexBatches[m_boundIndexBatch - 1];
+        Check9on12(startIndex + indexCount <= indexBatch.size());
+        RecordedCommand draw = { true, m_state, m_primitiveType, {} };
+        for (UINT i = startIndex; i < startIndex + indexCount; i++)
+        {
+            const UINT vertex = indexBatch[i] + baseVertex;
+            Check9on12(vertex < vertexBatch.size());
+            draw.m_vertices.push_back(vertexBatch[vertex]);
+        }
+        m_commands.push_back(std::move(draw));
+        m_draws++;
+    }
+
+    void OtherCommand() { m_commands.push_back({ false, 0, D3DPT_POINTLIST, {} }); }
+
+    std::vector<std::vector<UINT>> m_vertexBatches;
+    std::vector<std::vector<UINT>> m_indexBatches;
+    UINT m_boundVertexBatch = 0;
+    UINT m_boundIndexBatch = 0;
+    UINT m_state = 0;
+    D3DPRIMITIVETYPE m_primitiveType = D3DPT_POINTLIST;
+
+    std::vector<RecordedCommand> m_commands;
+    UINT m_draws = 0;
+    UINT m_bindings = 0;
+    UINT m_allocations = 0;
+};
+
+// Plays the part of Device and InputAssembly for UP draws: data is appended to fixed size upload batches, the bindings
+// and state are only resolved for draws that aren't appended, and anything that isn't a draw flushes the held back draw
+class MockDevice
+{
+public:
+    MockDevice(bool mergeDraws, UINT batchCapacity) : m_mergeDraws(mergeDraws), m_batchCapacity(batchCapacity) {}
+
+    void SetState(UINT state)
+    {
+        if (state != m_state)
+        {
+            m_state = state;
+            m_stateDirty = true;
+        }
+    }
+
+    void DrawPrimitiveUP(D3DPRIMITIVETYPE primitiveType, const std::vector<UINT>& vertices)
+    {
+        const UINT startVertex = Upload(m_context.m_vertexBatches, m_vertexBatchUsed, vertices);
+        const UINT vertexBatchId = static_cast<UINT>(m_context.m_vertexBatches.size());
+        const bool mergeable = m_mergeDraws && PendingDraw::IsMergeablePrimitiveType(primitiveType);
+        const bool append = mergeable && m_pendingDraw.CanAppend(primitiveType, false, vertexBatchId, 0) && !m_stateDirty;
+        if (!append)
+        {
+            Resolve(primitiveType);
+        }
+
+        if (mergeable)
+        {
+            m_pendingDraw.Record(m_context, append, primitiveType, false, static_cast<UINT>(vertices.size()), startVertex, 0, vertexBatchId, 0);
+        }
+        else
+        {
+            m_context.DrawInstanced(static_cast<UINT>(vertices.size()), 1, startVertex, 0);
+        }
+    }
+
+    // The indices are rebased to the vertices' position in the batch, so the base vertex stays 0 across the batch
+    void DrawIndexedPrimitiveUP(D3DPRIMITIVETYPE primitiveType, const std::vector<UINT>& vertices, const std::vector<UINT>& indices)
+    {
+        const UINT startVertex = Upload(m_context.m_vertexBatches, m_vertexBatchUsed, vertices);
+        std::vector<UINT> rebasedIndices;
+        for (UINT index : indices)
+        {
+            rebasedIndices.push_back(index + startVertex);
+        }
+        const UINT startIndex = Upload(m_context.m_indexBatches, m_indexBatchUsed, rebasedIndices);
+        const UINT vertexBatchId = static_cast<UINT>(m_context.m_vertexBatches.size());
+        const UINT indexBatchId = static_cast<UINT>(m_context.m_indexBatches.size());
+
+        const bool mergeable = m_mergeDraws && PendingDraw::IsMergeablePrimitiveType(primitiveType);
+        const bool append = mergeable && m_pendingDraw.CanAppend(primitiveType, true, vertexBatchId, indexBatchId) && !m_stateDirty;
+        if (!append)
+        {
+            Resolve(primitiveType);
+        }
+
+        if (mergeable)
+        {
+            m_pendingDraw.Record(m_context, append, primitiveType, true, static_cast<UINT>(indices.size()), startIndex, 0, vertexBatchId, indexBatchId);
+        }
+        else
+        {
+            m_context.DrawIndexedInstanced(static_cast<UINT>(indices.size()), 1, startIndex, 0, 0);
+        }
+    }
+
+    // Clears, blits, locks, queries, ... all record the held back draw first
+    void OtherCommand()
+    {
+        m_pendingDraw.Flush(m_context);
+        m_context.OtherCommand();
+    }
+
+    RecordingContext& Finish()
+    {
+        m_pendingDraw.Flush(m_context);
+        return m_context;
+    }
+
+private:
+    UINT Upload(std::vector<std::vector<UINT>>& batches, UINT& used, const std::vector<UINT>& data)
+    {
+        if (batches.empty() || used + data.size() > m_batchCapacity)
+        {
+            batches.emplace_back();
+            used = 0;
+            m_context.m_allocations++;
+        }
+        const UINT start = used;
+        batches.back().insert(batches.back().end(), data.begin(), data.end());
+        used += static_cast<UINT>(data.size());
+        return start;
+    }
+
+    void Resolve(D3DPRIMITIVETYPE primitiveType)
+    {
+        m_pendingDraw.Flush(m_context);
+
+        const UINT vertexBatchId = static_cast<UINT>(m_context.m_vertexBatches.size());
+        const UINT indexBatchId = static_cast<UINT>(m_context.m_indexBatches.size());
+        if (m_context.m_boundVertexBatch != vertexBatchId || m_context.m_boundIndexBatch != indexBatchId)
+        {
+            m_context.m_boundVertexBatch = vertexBatchId;
+            m_context.m_boundIndexBatch = indexBatchId;
+            m_context.m_bindings++;
+        }
+        m_context.m_state = m_state;
+        m_context.m_primitiveType = primitiveType;
+        m_stateDirty = false;
+    }
+
+    RecordingContext m_context;
+    PendingDraw m_pendingDraw;
+    const bool m_mergeDraws;
+    const UINT m_batchCapacity;
+    UINT m_vertexBatchUsed = 0;
+    UINT m_indexBatchUsed = 0;
+    UINT m_state = 0;
+    bool m_stateDirty = true;
+};
+
+// Draws are compared by what they rasterize: consecutive list draws with the same state are the same primitives as a
+// single draw of their concatenated vertices, while strips and fans and anything across another command stay separate
+static std::vector<RecordedCommand> Canonicalize(const std::vector<RecordedCommand>& commands)
+{
+    std::vector<RecordedCommand> canonical;
+    for (const RecordedCommand& command : commands)
+    {
+        if (command.m_isDraw && !canonical.empty() && canonical.back().m_isDraw &&
+            PendingDraw::IsMergeablePrimitiveType(command.m_primitiveType) &&
+            canonical.back().m_primitiveType == command.m_primitiveType &&
+            canonical.back().m_state == command.m_state)
+        {
+            canonical.back().m_vertices.insert(canonical.back().m_vertices.end(), command.m_vertices.begin(), command.m_vertices.end());
+        }
+        else
+        {
+            canonical.push_back(command);
+        }
+    }
+    return canonical;
+}
+
+static bool SameCommands(const std::vector<RecordedCommand>& a, const std::vector<RecordedCommand>& b)
+{
+    const std::vector<RecordedCommand> canonicalA = Canonicalize(a);
+    const std::vector<RecordedCommand> canonicalB = Canonicalize(b);
+    TEST_CHECK(canonicalA.size() == canonicalB.size());
+    for (size_t i = 0; i < canonicalA.size(); i++)
+    {
+        TEST_CHECK(canonicalA[i].m_isDraw == canonicalB[i].m_isDraw);
+        TEST_CHECK(canonicalA[i].m_state == canonicalB[i].m_state);
+        TEST_CHECK(canonicalA[i].m_primitiveType == canonicalB[i].m_primitiveType);
+        TEST_CHECK(canonicalA[i].m_vertices == canonicalB[i].m_vertices);
+    }
+    return true;
+}
+
+static UINT VertexCount(D3DPRIMITIVETYPE primitiveType, UINT primitiveCount)
+{
+    switch (primitiveType)
+    {
+    case D3DPT_POINTLIST: return primitiveCount;
+    case D3DPT_LINELIST: return primitiveCount * 2;
+    case D3DPT_LINESTRIP: return primitiveCount + 1;
+    case D3DPT_TRIANGLELIST: return primitiveCount * 3;
+    default: return primitiveCount + 2;
+    }
+}
+
+// The app's side of the recording. Each draw gets vertex data no other draw has, so a draw that reads the wrong batch
+// or range shows up when the replays are compared.
+struct AppCall
+{
+    enum Type { Draw, IndexedDraw, SetState, OtherCommand };
+    Type m_type;
+    D3DPRIMITIVETYPE m_primitiveType;
+    UINT m_state;
+    std::vector<UINT> m_vertices;
+    std::vector<UINT> m_indices;
+};
+
+class AppRecording
+{
+public:
+    void Draw(D3DPRIMITIVETYPE primitiveType, UINT primitiveCount)
+    {
+        m_calls.push_back({ AppCall::Draw, primitiveType, 0, NewVertices(VertexCount(primitiveType, primitiveCount)), {} });
+    }
+
+    // Indexes the vertices back to front so the index data matters
+    void DrawIndexed(D3DPRIMITIVETYPE primitiveType, UINT primitiveCount)
+    {
+        const UINT count = VertexCount(primitiveType, primitiveCount);
+        std::vector<UINT> indices;
+        for (UINT i = 0; i < count; i++)
+        {
+            indices.push_back(count - 1 - i);
+        }
+        m_calls.push_back({ AppCall::IndexedDraw, primitiveType, 0, NewVertices(count), std::move(indices) });
+    }
+
+    void SetState(UINT state) { m_calls.push_back({ AppCall::SetState, D3DPT_POINTLIST, state, {}, {} }); }
+    void OtherCommand() { m_calls.push_back({ AppCall::OtherCommand, D3DPT_POINTLIST, 0, {}, {} }); }
+
+    RecordingContext Replay(bool mergeDraws, UINT batchCapacity) const
+    {
+        MockDevice device(mergeDraws, batchCapacity);
+        for (const AppCall& call : m_calls)
+        {
+            switch (call.m_type)
+            {
+            case AppCall::Draw: device.DrawPrimitiveUP(call.m_primitiveType, call.m_vertices); break;
+            case AppCall::IndexedDraw: device.DrawIndexedPrimitiveUP(call.m_primitiveType, call.m_vertices, call.m_indices); break;
+            case AppCall::SetState: device.SetState(call.m_state); break;
+            case AppCall::OtherCommand: device.OtherCommand(); break;
+            }
+        }
+        return device.Finish();
+    }
+
+private:
+    std::vector<UINT> NewVertices(UINT count)
+    {
+        std::vector<UINT> vertices;
+        for (UINT i = 0; i < count; i++)
+        {
+            vertices.push_back(m_nextVertex++);
+        }
+        return vertices;
+    }
+
+    std::vector<AppCall> m_calls;
+    UINT m_nextVertex = 1;
+};
+
+static const UINT cBatchCapacity = 4096;
+
+// The replays only ever append contiguous draws from the bound batches, these are the cases the checks guard against
+static bool TestDrawsAreOnlyAppendedToMatchingBatchesAndRanges()
+{
+    RecordingContext context;
+    context.m_vertexBatches = { std::vector<UINT>(64, 1), std::vector<UINT>(64, 2) };
+    context.m_indexBatches = { std::vector<UINT>(64, 0), std::vector<UINT>(64, 0) };
+    context.m_boundVertexBatch = 1;
+    context.m_boundIndexBatch = 1;
+
+    PendingDraw pendingDraw;
+    TEST_CHECK(!pendingDraw.CanAppend(D3DPT_TRIANGLELIST, false, 1, 0));
+    pendingDraw.Record(context, false, D3DPT_TRIANGLELIST, false, 6, 0, 0, 1, 0);
+    TEST_CHECK(pendingDraw.IsPending());
+    TEST_CHECK(pendingDraw.CanAppend(D3DPT_TRIANGLELIST, false, 1, 0));
+    TEST_CHECK(!pendingDraw.CanAppend(D3DPT_TRIANGLELIST, false, 2, 0));
+    TEST_CHECK(!pendingDraw.CanAppend(D3DPT_LINELIST, false, 1, 0));
+    TEST_CHECK(!pendingDraw.CanAppend(D3DPT_TRIANGLELIST, true, 1, 1));
+
+    // Appending something that doesn't follow the pending draw's range records them separately
+    pendingDraw.Record(context, true, D3DPT_TRIANGLELIST, false, 3, 9, 0, 1, 0);
+    TEST_CHECK(context.m_draws == 1);
+    pendingDraw.Record(context, true, D3DPT_TRIANGLELIST, false, 3, 12, 0, 1, 0);
+    pendingDraw.Flush(context);
+    TEST_CHECK(context.m_draws == 2);
+    TEST_CHECK(context.m_commands[1].m_vertices.size() == 6);
+    TEST_CHECK(!pendingDraw.IsPending());
+
+    pendingDraw.Record(context, false, D3DPT_LINELIST, true, 4, 0, 0, 1, 1);
+    TEST_CHECK(pendingDraw.CanAppend(D3DPT_LINELIST, true, 1, 1));
+    TEST_CHECK(!pendingDraw.CanAppend(D3DPT_LINELIST, true, 1, 2));
+
+    // A draw that wasn't uploaded into the batches is recorded right away
+    pendingDraw.Record(context, false, D3DPT_POINTLIST, false, 4, 0, 0, 0, 0);
+    TEST_CHECK(!pendingDraw.IsPending());
+    TEST_CHECK(context.m_draws == 4);
+    return true;
+}
+
+static bool TestBackToBackListDrawsMerge()
+{
+    AppRecording app;
+    for (UINT i = 0; i < 100; i++)
+    {
+        app.Draw(D3DPT_TRIANGLELIST, 2);
+    }
+
+    const RecordingContext merged = app.Replay(true, cBatchCapacity);
+    const RecordingContext separate = app.Replay(false, cBatchCapacity);
+    TEST_CHECK(SameCommands(merged.m_commands, separate.m_commands));
+    TEST_CHECK(merged.m_draws == 1);
+    TEST_CHECK(merged.m_bindings == 1);
+    TEST_CHECK(merged.m_allocations == 1);
+    TEST_CHECK(separate.m_draws == 100);
+    return true;
+}
+
+static bool TestIndexedDrawsMerge()
+{
+    AppRecording app;
+    for (UINT i = 0; i < 50; i++)
+    {
+        app.DrawIndexed(D3DPT_LINELIST, 3);
+    }
+
+    const RecordingContext merged = app.Replay(true, cBatchCapacity);
+    const RecordingContext separate = app.Replay(false, cBatchCapacity);
+    TEST_CHECK(SameCommands(merged.m_commands, separate.m_commands));
+    TEST_CHECK(merged.m_draws == 1);
+    TEST_CHECK(merged.m_bindings == 1);
+    TEST_CHECK(separate.m_draws == 50);
+    return true;
+}
+
+static bool TestStateChangesAndOtherCommandsEndTheMerge()
+{
+    AppRecording app;
+    for (UINT group = 0; group < 12; group++)
+    {
+        if (group % 3 == 2)
+        {
+            app.OtherCommand();
+        }
+        else
+        {
+            app.SetState(group);
+        }
+        for (UINT i = 0; i < 5; i++)
+        {
+            app.Draw(D3DPT_POINTLIST, 4);
+        }
+    }
+
+    const RecordingContext merged = app.Replay(true, cBatchCapacity);
+    TEST_CHECK(SameCommands(merged.m_commands, app.Replay(false, cBatchCapacity).m_commands));
+    TEST_CHECK(merged.m_draws == 12);
+
+    // The other commands must come after the draws the app made before them
+    TEST_CHECK(merged.m_commands.size() == 12 + 4);
+    TEST_CHECK(!merged.m_commands[2].m_isDraw && merged.m_commands[1].m_isDraw && merged.m_commands[3].m_isDraw);
+    return true;
+}
+
+static bool TestStripsFansAndTopologyChangesAreNotMerged()
+{
+    AppRecording app;
+    for (UINT i = 0; i < 10; i++)
+    {
+        app.Draw(D3DPT_TRIANGLESTRIP, 2);
+        app.Draw(D3DPT_TRIANGLEFAN, 2);
+        app.Draw(D3DPT_LINESTRIP, 2);
+    }
+    for (UINT i = 0; i < 10; i++)
+    {
+        app.Draw((i & 1) ? D3DPT_LINELIST : D3DPT_TRIANGLELIST, 1);
+    }
+
+    const RecordingContext merged = app.Replay(true, cBatchCapacity);
+    TEST_CHECK(SameCommands(merged.m_commands, app.Replay(false, cBatchCapacity).m_commands));
+    TEST_CHECK(merged.m_draws == 40);
+    return true;
+}
+
+static bool TestUploadBatchRolloverStartsANewDraw()
+{
+    // Three draws of 9 vertices fit in each batch
+    AppRecording app;
+    for (UINT i = 0; i < 12; i++)
+    {
+        app.Draw(D3DPT_TRIANGLELIST, 3);
+    }
+
+    const RecordingContext merged = app.Replay(true, 30);
+    const RecordingContext separate = app.Replay(false, 30);
+    TEST_CHECK(SameCommands(merged.m_commands, separate.m_commands));
+    TEST_CHECK(merged.m_allocations == 4);
+    TEST_CHECK(merged.m_draws == 4);
+    TEST_CHECK(merged.m_bindings == 4);
+    TEST_CHECK(separate.m_allocations == 4);
+    TEST_CHECK(separate.m_bindings == 4);
+    return true;
+}
+
+static bool TestRandomReplaysMatch()
+{
+    const D3DPRIMITIVETYPE cPrimitiveTypes[] = { D3DPT_POINTLIST, D3DPT_LINELIST, D3DPT_LINESTRIP, D3DPT_TRIANGLELIST, D3DPT_TRIANGLESTRIP, D3DPT_TRIANGLEFAN };
+    for (UINT seed = 0; seed < 20; seed++)
+    {
+        std::mt19937 random(seed);
+        AppRecording app;
+        for (UINT i = 0; i < 2000; i++)
+        {
+            const UINT action = random() % 100;
+            const D3DPRIMITIVETYPE primitiveType = cPrimitiveTypes[random() % std::size(cPrimitiveTypes)];
+            const UINT primitiveCount = 1 + random() % 20;
+            if (action < 60)
+            {
+                app.Draw(primitiveType, primitiveCount);
+            }
+            else if (action < 85)
+            {
+                app.DrawIndexed(primitiveType, primitiveCount);
+            }
+            else if (action < 95)
+            {
+                app.SetState(random() % 3);
+            }
+            else
+            {
+                app.OtherCommand();
+            }
+        }
+
+        const UINT batchCapacity = 64 + random() % 512;
+        const RecordingContext merged = app.Replay(true, batchCapacity);
+        const RecordingContext separate = app.Replay(false, batchCapacity);
+        TEST_CHECK(SameCommands(merged.m_commands, separate.m_commands));
+        TEST_CHECK(merged.m_draws < separate.m_draws);
+        TEST_CHECK(merged.m_bindings <= separate.m_bindings);
+        TEST_CHECK(merged.m_allocations == separate.m_allocations);
+    }
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "DrawsAreOnlyAppendedToMatchingBatchesAndRanges", TestDrawsAreOnlyAppendedToMatchingBatchesAndRanges },
+        { "BackToBackListDrawsMerge", TestBackToBackListDrawsMerge },
+        { "IndexedDrawsMerge", TestIndexedDrawsMerge },
+        { "StateChangesAndOtherCommandsEndTheMerge", TestStateChangesAndOtherCommandsEndTheMerge },
+        { "StripsFansAndTopologyChangesAreNotMerged", TestStripsFansAndTopologyChangesAreNotMerged },
+        { "UploadBatchRolloverStartsANewDraw", TestUploadBatchRolloverStartsANewDraw },
+        { "RandomReplaysMatch", TestRandomReplaysMatch },
+    };
+    return RunTests(cTests);
+}
@@ -0,0 +1,137 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12PipelineStateDirtyFlags.h>
+
+using namespace D3D9on12;
+
+// Calls check with every PipelineStateDirtyFlags that has a single flag set
+template<typename CheckFn>
+static bool ForEachFlag(CheckFn&& check)
+{
+    for (UINT i = 0; i < 64; i++)
+    {
+        PipelineStateDirtyFlags flags;
+        flags.MiscFlags = 1ull << i;
+        if (!check(flags))
+        {
+            return false;
+        }
+    }
+    for (UINT i = 0; i < 64; i++)
+    {
+        PipelineStateDirtyFlags flags;
+        flags.PSOFlags = 1ull << i;
+        if (!check(flags))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool TestCleanFlagsSkipTheResolve()
+{
+    PipelineStateDirtyFlags flags;
+    TEST_CHECK(flags.CanSkipResolve(false, false));
+    TEST_CHECK(!flags.AreVertexStageInputsDirty());
+
+    // Byte offset draws always rebind their VB/IB
+    TEST_CHECK(!flags.CanSkipResolve(true, false));
+    TEST_CHECK(!flags.CanSkipResolve(false, true));
+    return true;
+}
+
+// Any dirty flag at all, including ones added later, makes the next draw go through the full resolve
+static bool TestEveryFlagPreventsTheSkip()
+{
+    return ForEachFlag([](PipelineStateDirtyFlags& flags)
+    {
+        TEST_CHECK(!flags.CanSkipResolve(false, false));
+        return true;
+    });
+}
+
+static bool TestVertexStageInputs()
+{
+    PipelineStateDirtyFlags vertexStageInputs;
+    vertexStageInputs.Viewport = 1;
+    vertexStageInputs.PointSize = 1;
+    vertexStageInputs.VSExtension = 1;
+    vertexStageInputs.VertexShader = 1;
+    vertexStageInputs.InputLayout = 1;
+    vertexStageInputs.PixelShader = 1;
+    vertexStageInputs.GeometryShader = 1;
+
+    return ForEachFlag([&vertexStageInputs](PipelineStateDirtyFlags& flags)
+    {
+        const bool isVertexStageInput = (flags.MiscFlags & vertexStageInputs.MiscFlags) != 0 || (flags.PSOFlags & vertexStageInputs.PSOFlags) != 0;
+        TEST_CHECK(flags.AreVertexStageInputsDirty() == isVertexStageInput);
+        return true;
+    });
+}
+
+// A draw with byte offsets leaves its VB/IB dirty, so the draw after it isn't skipped and puts the bindings back
+static bool TestByteOffsetDrawsDirtyTheNextDraw()
+{
+    PipelineStateDirtyFlags flags;
+    flags.BlendState = 1;
+    flags.Textures = 0x3;
+
+    flags.ClearAfterResolve(true, false, 0);
+    TEST_CHECK(flags.VertexBuffers == 1 && flags.IndexBuffer == 0);
+    TEST_CHECK(flags.BlendState == 0 && flags.Textures == 0);
+    TEST_CHECK(!flags.CanSkipResolve(false, false));
+
+    flags.ClearAfterResolve(false, true, 0);
+    TEST_CHECK(flags.VertexBuffers == 0 && flags.IndexBuffer == 1);
+    TEST_CHECK(!flags.CanSkipResolve(false, false));
+
+    flags.ClearAfterResolve(false, false, 0);
+    TEST_CHECK(flags.CanSkipResolve(false, false));
+    return true;
+}
+
+// Textures the pixel stage couldn't resolve yet stay dirty
+static bool TestKeptTexturesStayDirty()
+{
+    PipelineStateDirtyFlags flags;
+    flags.ClearAfterResolve(false, false, 0x5);
+    TEST_CHECK(flags.Textures == 0x5);
+    TEST_CHECK(!flags.CanSkipResolve(false, false));
+    return true;
+}
+
+// Draws that merge may only differ in their UP vertex and index data
+static bool TestOnlyInputBuffersDirty()
+{
+    PipelineStateDirtyFlags flags;
+    TEST_CHECK(flags.AreOnlyInputBuffersDirty());
+    flags.VertexBuffers = 1;
+    flags.IndexBuffer = 1;
+    TEST_CHECK(flags.AreOnlyInputBuffersDirty());
+
+    flags.Textures = 1;
+    TEST_CHECK(!flags.AreOnlyInputBuffersDirty());
+    flags.Textures = 0;
+    flags.Samplers = 1u << 20;
+    TEST_CHECK(!flags.AreOnlyInputBuffersDirty());
+    flags.Samplers = 0;
+    flags.Topology = 1;
+    TEST_CHECK(!flags.AreOnlyInputBuffersDirty());
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "CleanFlagsSkipTheResolve", TestCleanFlagsSkipTheResolve },
+        { "EveryFlagPreventsTheSkip", TestEveryFlagPreventsTheSkip },
+        { "VertexStageInputs", TestVertexStageInputs },
+        { "ByteOffsetDrawsDirtyTheNextDraw", TestByteOffsetDrawsDirtyTheNextDraw },
+        { "KeptTexturesStayDirty", TestKeptTexturesStayDirty },
+        { "OnlyInputBuffersDirty", TestOnlyInputBuffersDirty },
+    };
+    return RunTests(cTests);
+}
@@ -0,0 +1,156 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12QueryResultCache.h>
+
+using namespace D3D9on12;
+
+// Stands in for the translation layer query: an End records a new result, which only becomes readable once the GPU
+// has finished it
+class MockQuery
+{
+public:
+    void Begin() {}
+    void End() { m_result = ++m_numEnds; m_isFinished = false; }
+    void Finish() { m_isFinished = m_numEnds > 0; }
+
+    bool GetData(void* pData, UINT dataSize)
+    {
+        m_numPolls++;
+        if (!m_isFinished)
+        {
+            return false;
+        }
+        TEST_CHECK(dataSize == sizeof(m_result));
+        memcpy(pData, &m_result, sizeof(m_result));
+        return true;
+    }
+
+    UINT64 m_result = 0;
+    UINT64 m_numEnds = 0;
+    bool m_isFinished = false;
+    UINT m_numPolls = 0;
+};
+
+// What Query::Issue and Query::GetData do with the cache around the underlying query
+class TestQuery
+{
+public:
+    void Issue(bool isBegin)
+    {
+        m_resultCache.Reset();
+        if (isBegin)
+        {
+            m_query.Begin();
+        }
+        else
+        {
+            m_query.End();
+        }
+    }
+
+    bool GetData(UINT64& result)
+    {
+        return m_resultCache.GetResult(&result, sizeof(result), [this](void* pResult, UINT resultSize)
+        {
+            return m_query.GetData(pResult, resultSize);
+        });
+    }
+
+    MockQuery m_query;
+    QueryResultCache<16> m_resultCache;
+};
+
+static bool TestFinishedResultIsPolledOnce()
+{
+    TestQuery query;
+    query.Issue(true);
+    query.Issue(false);
+
+    UINT64 result;
+    TEST_CHECK(!query.GetData(result));
+    TEST_CHECK(!query.GetData(result));
+    TEST_CHECK(query.m_query.m_numPolls == 2);
+
+    query.m_query.Finish();
+    for (UINT i = 0; i < 10; i++)
+    {
+        result = 0;
+        TEST_CHECK(query.GetData(result));
+        TEST_CHECK(result == 1);
+    }
+    TEST_CHECK(query.m_query.m_numPolls == 3);
+    return true;
+}
+
+static bool TestIssueResetsTheCachedResult()
+{
+    TestQuery query;
+    query.Issue(false);
+    query.m_query.Finish();
+
+    UINT64 result;
+    TEST_CHECK(query.GetData(result) && result == 1);
+
+    // Both a Begin and the End that follows drop the old result, even though nothing new is available yet
+    query.Issue(true);
+    TEST_CHECK(!query.m_resultCache.IsResultCached());
+    query.Issue(false);
+    TEST_CHECK(!query.GetData(result));
+
+    query.m_query.Finish();
+    TEST_CHECK(query.GetData(result) && result == 2);
+    return true;
+}
+
+// Random Issue/Finish/GetData sequences against the rule that GetData only ever returns the latest End's result
+static bool TestRandomizedNeverReturnsAnEarlierResult()
+{
+    std::mt19937 random(47);
+    for (UINT sequence = 0; sequence < 100; sequence++)
+    {
+        TestQuery query;
+        for (UINT step = 0; step < 200; step++)
+        {
+            switch (random() % 4)
+            {
+            case 0:
+                query.Issue(true);
+                break;
+            case 1:
+                query.Issue(false);
+                break;
+            case 2:
+                query.m_query.Finish();
+                break;
+            default:
+            {
+                const UINT numPolls = query.m_query.m_numPolls;
+                const bool wasCached = query.m_resultCache.IsResultCached();
+
+                UINT64 result = 0;
+                const bool isAvailable = query.GetData(result);
+                TEST_CHECK(isAvailable == query.m_query.m_isFinished);
+                if (isAvailable)
+                {
+                    TEST_CHECK(result == query.m_query.m_numEnds);
+                }
+                TEST_CHECK(query.m_query.m_numPolls == numPolls + (wasCached ? 0 : 1));
+                break;
+            }
+            }
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "FinishedResultIsPolledOnce", TestFinishedResultIsPolledOnce },
+        { "IssueResetsTheCachedResult", TestIssueResetsTheCachedResult },
+        { "RandomizedNeverReturnsAnEarlierResult", TestRandomizedNeverReturnsAnEarlierResult },
+    };
+    return RunTests(cTests);
+}
@@ -0,0 +1,120 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12SamplerState.h>
+
+using namespace D3D9on12;
+
+static const UINT cFilters[] = { D3DTEXF_NONE, D3DTEXF_POINT, D3DTEXF_LINEAR, D3DTEXF_ANISOTROPIC, D3DTEXF_PYRAMIDALQUAD, D3DTEXF_GAUSSIANQUAD };
+static const UINT cAddressModes[] = { D3DTADDRESS_WRAP, D3DTADDRESS_MIRROR, D3DTADDRESS_CLAMP, D3DTADDRESS_BORDER, D3DTADDRESS_MIRRORONCE };
+
+static SamplerStateID RandomSamplerStateID(std::mt19937 &random)
+{
+    auto pick = [&](const UINT *pValues, size_t count) { return pValues[random() % count]; };
+
+    SamplerStateID id;
+    id.MagFilter = pick(cFilters, std::size(cFilters));
+    id.MinFilter = pick(cFilters, std::size(cFilters));
+    id.MipFilter = pick(cFilters, 3);
+    id.AddressU = pick(cAddressModes, std::size(cAddressModes));
+    id.AddressV = pick(cAddressModes, std::size(cAddressModes));
+    id.AddressW = pick(cAddressModes, std::size(cAddressModes));
+    id.MaxAnisotropy = 1 + random() % 16;
+    id.UseHardwareShadowMapping = random() % 2;
+    id.SwapRBBorderColors = random() % 2;
+    id.BorderColor = static_cast<UINT>(random());
+    id.MaxMipLevel = random() % 12;
+    id.MipLODBias = static_cast<FLOAT>(static_cast<int>(random() % 9) - 4) * 0.5f;
+    return id;
+}
+
+static bool UsesBorderColor(const SamplerStateID &id)
+{
+    return id.AddressU == D3DTADDRESS_BORDER || id.AddressV == D3DTADDRESS_BORDER || id.AddressW == D3DTADDRESS_BORDER;
+}
+
+static bool IsAnisotropic(const SamplerStateID &id)
+{
+    return id.MinFilter == D3DTEXF_ANISOTROPIC || id.MagFilter == D3DTEXF_ANISOTROPIC;
+}
+
+// Canonicalizing must never touch the filters, address modes or comparison, and must keep every field that can still
+// change what the sampler returns
+static bool TestPreservesObservableState()
+{
+    std::mt19937 random(42);
+    for (UINT i = 0; i < 100000; i++)
+    {
+        const SamplerStateID id = RandomSamplerStateID(random);
+        const SamplerStateID canonical = CanonicalizeSamplerStateID(id);
+
+        TEST_CHECK(canonical.MagFilter == id.MagFilter && canonical.MinFilter == id.MinFilter && canonical.MipFilter == id.MipFilter);
+        TEST_CHECK(canonical.AddressU == id.AddressU && canonical.AddressV == id.AddressV && canonical.AddressW == id.AddressW);
+        TEST_CHECK(canonical.UseHardwareShadowMapping == id.UseHardwareShadowMapping);
+
+        if (UsesBorderColor(id))
+        {
+            TEST_CHECK(canonical.BorderColor == id.BorderColor && canonical.SwapRBBorderColors == id.SwapRBBorderColors);
+        }
+        if (IsAnisotropic(id))
+        {
+            TEST_CHECK(canonical.MaxAnisotropy == id.MaxAnisotropy);
+        }
+        if (id.MipFilter != D3DTEXF_NONE || id.MinFilter != id.MagFilter || IsAnisotropic(id))
+        {
+            TEST_CHECK(canonical.MipLODBias == id.MipLODBias && canonical.MaxMipLevel == id.MaxMipLevel);
+        }
+
+        // Canonical IDs are cache keys, so canonicalizing one again must not change it
+        TEST_CHECK(CanonicalizeSamplerStateID(canonical) == canonical);
+    }
+    return true;
+}
+
+// Samplers that only differ in ignored fields have to land on the same cache entry
+static bool TestCollapsesIgnoredState()
+{
+    SamplerStateID first;
+    first.MagFilter = D3DTEXF_LINEAR;
+    first.MinFilter = D3DTEXF_LINEAR;
+    first.MipFilter = D3DTEXF_NONE;
+    first.AddressU = D3DTADDRESS_WRAP;
+    first.AddressV = D3DTADDRESS_CLAMP;
+    first.AddressW = D3DTADDRESS_MIRROR;
+
+    SamplerStateID second = first;
+    first.MaxAnisotropy = 16;
+    first.BorderColor = 0xFF00FF00;
+    first.SwapRBBorderColors = 1;
+    first.MipLODBias = -1.5f;
+    first.MaxMipLevel = 3;
+    second.MaxAnisotropy = 2;
+    second.BorderColor = 0x12345678;
+    second.MipLODBias = 2.0f;
+    second.MaxMipLevel = 7;
+    TEST_CHECK(first != second);
+    TEST_CHECK(CanonicalizeSamplerStateID(first) == CanonicalizeSamplerStateID(second));
+
+    // Any border address keeps the border color, and mipmapping keeps the LOD state
+    first.AddressW = D3DTADDRESS_BORDER;
+    second.AddressW = D3DTADDRESS_BORDER;
+    TEST_CHECK(CanonicalizeSamplerStateID(first) != CanonicalizeSamplerStateID(second));
+    second.BorderColor = first.BorderColor;
+    second.SwapRBBorderColors = first.SwapRBBorderColors;
+    TEST_CHECK(CanonicalizeSamplerStateID(first) == CanonicalizeSamplerStateID(second));
+
+    first.MipFilter = D3DTEXF_POINT;
+    second.MipFilter = D3DTEXF_POINT;
+    TEST_CHECK(CanonicalizeSamplerStateID(first) != CanonicalizeSamplerStateID(second));
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "PreservesObservableState", TestPreservesObservableState },
+        { "CollapsesIgnoredState", TestCollapsesIgnoredState },
+    };
+    return RunTests(cTests);
+}
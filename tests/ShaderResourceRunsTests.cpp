@@ -0,0 +1,77 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12ShaderResourceRuns.h>
+
+using namespace D3D9on12;
+
+typedef std::vector<std::pair<UINT, UINT>> Runs;
+
+static Runs GetRuns(UINT changedMask)
+{
+    Runs runs;
+    ForEachShaderResourceRun(changedMask, [&runs](UINT first, UINT count) { runs.push_back({ first, count }); });
+    return runs;
+}
+
+static bool TestConsecutiveSlotsAreOneCall()
+{
+    TEST_CHECK(GetRuns(0).empty());
+    TEST_CHECK(GetRuns(0x1) == Runs({ { 0, 1 } }));
+    TEST_CHECK(GetRuns(0xF) == Runs({ { 0, 4 } }));
+    TEST_CHECK(GetRuns(0xFFFF) == Runs({ { 0, 16 } }));
+    TEST_CHECK(GetRuns(BIT(2) | BIT(3) | BIT(7) | BIT(9) | BIT(10)) == Runs({ { 2, 2 }, { 7, 1 }, { 9, 2 } }));
+    return true;
+}
+
+// The pixel and vertex samplers are bound to different stages, so a run never crosses from one to the other
+static bool TestRunsStopAtThePixelSamplers()
+{
+    TEST_CHECK(GetRuns(BIT(14) | BIT(15) | BIT(16) | BIT(17)) == Runs({ { 14, 2 }, { 16, 2 } }));
+    TEST_CHECK(GetRuns((1u << MAX_SAMPLERS_STAGES) - 1) == Runs({ { 0, MAX_PIXEL_SAMPLERS }, { MAX_PIXEL_SAMPLERS, MAX_SAMPLERS_STAGES - MAX_PIXEL_SAMPLERS } }));
+    return true;
+}
+
+// Every changed slot is bound exactly once, in as few calls as the stage split allows
+static bool TestRandomizedMasks()
+{
+    std::mt19937 random(43);
+    for (UINT i = 0; i < 10000; i++)
+    {
+        const UINT changedMask = random() & ((1u << MAX_SAMPLERS_STAGES) - 1);
+        const Runs runs = GetRuns(changedMask);
+
+        UINT boundMask = 0;
+        UINT expectedRuns = 0;
+        for (UINT slot = 0; slot < MAX_SAMPLERS_STAGES; slot++)
+        {
+            const bool startsRun = (changedMask & BIT(slot)) && (slot == 0 || slot == MAX_PIXEL_SAMPLERS || !(changedMask & BIT(slot - 1)));
+            expectedRuns += startsRun ? 1 : 0;
+        }
+        TEST_CHECK(runs.size() == expectedRuns);
+
+        for (const auto& run : runs)
+        {
+            TEST_CHECK(run.second > 0);
+            TEST_CHECK((run.first < MAX_PIXEL_SAMPLERS) == (run.first + run.second <= MAX_PIXEL_SAMPLERS));
+            for (UINT slot = run.first; slot < run.first + run.second; slot++)
+            {
+                TEST_CHECK((boundMask & BIT(slot)) == 0);
+                boundMask |= BIT(slot);
+            }
+        }
+        TEST_CHECK(boundMask == changedMask);
+    }
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "ConsecutiveSlotsAreOneCall", TestConsecutiveSlotsAreOneCall },
+        { "RunsStopAtThePixelSamplers", TestRunsStopAtThePixelSamplers },
+        { "RandomizedMasks", TestRandomizedMasks },
+    };
+    return RunTests(cTests);
+}
@@ -0,0 +1,67 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12SubresourceCopy.h>
+#include <chrono>
+
+using namespace D3D9on12;
+
+// Throughput of the system memory readback copy for common surface sizes and texel sizes, with tightly packed and
+// padded (256 byte aligned, like D3D12 readback footprints) rows. Compares d3dx12's row by row copy against the
+// coalesced copy and the split copy, so the split threshold can be picked for the machine it runs on.
+static double MeasureGBps(SIZE_T bytes, const std::function<void()> &copy)
+{
+    copy(); // Fault the pages in before timing
+    const int cIterations = static_cast<int>(max<SIZE_T>(1, (256ull * 1024 * 1024) / bytes));
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < cIterations; i++)
+    {
+        copy();
+    }
+    const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    return double(bytes) * cIterations / seconds.count() / 1e9;
+}
+
+int main()
+{
+    static const UINT cSizes[] = { 256, 512, 1024, 2048, 4096 };
+    static const UINT cBytesPerTexel[] = { 1, 4, 8, 16 };
+
+    printf("%u copy workers\n", GetSubresourceCopyWorkerCount());
+    printf("%-10s %-6s %-7s %10s %12s %12s %12s\n", "size", "texel", "rows", "MB", "rowwise", "coalesced", "split");
+    for (UINT size : cSizes)
+    {
+        for (UINT bytesPerTexel : cBytesPerTexel)
+        {
+            for (bool padded : { false, true })
+            {
+                const SIZE_T rowSize = SIZE_T(size) * bytesPerTexel;
+                const SIZE_T srcRowPitch = padded ? (rowSize + 256 + 255) & ~SIZE_T(255) : rowSize;
+                const SIZE_T dstRowPitch = rowSize;
+                std::vector<BYTE> source(srcRowPitch * size, 1);
+                std::vector<BYTE> destination(dstRowPitch * size);
+                const SIZE_T bytes = rowSize * size;
+
+                const double rowwise = MeasureGBps(bytes, [&]()
+                {
+                    for (UINT y = 0; y < size; y++)
+                    {
+                        memcpy(&destination[dstRowPitch * y], &source[srcRowPitch * y], rowSize);
+                    }
+                });
+                const double coalesced = MeasureGBps(bytes, [&]()
+                {
+                    CopyRowsCoalesced(destination.data(), dstRowPitch, 0, source.data(), srcRowPitch, 0, rowSize, size, 1);
+                });
+                const double split = MeasureGBps(bytes, [&]()
+                {
+                    CopyRowsParallel(destination.data(), dstRowPitch, 0, source.data(), srcRowPitch, 0, rowSize, size, 1, 1, GetSubresourceCopyWorkerCount());
+                });
+
+                printf("%4ux%-5u %-6u %-7s %10.2f %9.2f GB/s %7.2f GB/s %7.2f GB/s\n",
+                    size, size, bytesPerTexel, padded ? "padded" : "packed", bytes / (1024.0 * 1024.0), rowwise, coalesced, split);
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
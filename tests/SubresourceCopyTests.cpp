@@ -0,0 +1,128 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12SubresourceCopy.h>
+
+using namespace D3D9on12;
+
+struct CopyLayout
+{
+    SIZE_T m_rowSizeInBytes;
+    UINT m_numRows;
+    UINT m_numSlices;
+    SIZE_T m_srcRowPadding;
+    SIZE_T m_dstRowPadding;
+    SIZE_T m_srcSlicePadding;
+    SIZE_T m_dstSlicePadding;
+};
+
+// Copies the layout, splitting it across every worker when parallelThreshold is 1 regardless of the host's thread count,
+// and compares every destination byte against a row by row reference. Padding bytes must be left untouched.
+static bool CheckCopy(const CopyLayout &layout, UINT64 parallelThreshold)
+{
+    const SIZE_T srcRowPitch = layout.m_rowSizeInBytes + layout.m_srcRowPadding;
+    const SIZE_T dstRowPitch = layout.m_rowSizeInBytes + layout.m_dstRowPadding;
+    const SIZE_T srcSlicePitch = srcRowPitch * layout.m_numRows + layout.m_srcSlicePadding;
+    const SIZE_T dstSlicePitch = dstRowPitch * layout.m_numRows + layout.m_dstSlicePadding;
+
+    std::vector<BYTE> source(srcSlicePitch * layout.m_numSlices);
+    for (size_t i = 0; i < source.size(); i++)
+    {
+        source[i] = static_cast<BYTE>(i * 7 + i / 251);
+    }
+
+    const BYTE cPadding = 0xCD;
+    std::vector<BYTE> expected(dstSlicePitch * layout.m_numSlices, cPadding);
+    for (UINT z = 0; z < layout.m_numSlices; z++)
+    {
+        for (UINT y = 0; y < layout.m_numRows; y++)
+        {
+            memcpy(&expected[dstSlicePitch * z + dstRowPitch * y], &source[srcSlicePitch * z + srcRowPitch * y], layout.m_rowSizeInBytes);
+        }
+    }
+
+    std::vector<BYTE> destination(expected.size(), cPadding);
+    CopyRowsParallel(destination.data(), dstRowPitch, dstSlicePitch, source.data(), srcRowPitch, srcSlicePitch,
+        layout.m_rowSizeInBytes, layout.m_numRows, layout.m_numSlices, parallelThreshold, cMaxSubresourceCopyWorkers);
+    TEST_CHECK(destination == expected);
+    return true;
+}
+
+static const CopyLayout cLayouts[] =
+{
+    { 256, 64, 1, 0, 0, 0, 0 },     // Tightly packed 2D
+    { 256, 64, 1, 0, 256, 0, 0 },   // Padded destination rows
+    { 100, 37, 1, 28, 12, 0, 0 },   // Padded rows on both sides, rows don't split evenly across workers
+    { 64, 16, 9, 0, 0, 0, 0 },      // Tightly packed volume
+    { 64, 16, 9, 0, 0, 64, 0 },     // Padded source slices
+    { 48, 5, 7, 16, 80, 32, 128 },  // Everything padded, chunks span slices
+    { 12, 1, 1, 0, 0, 0, 0 },       // Single row
+    { 12, 3, 1, 0, 0, 0, 0 },       // Fewer rows than workers
+};
+
+static bool TestCoalescedCopy()
+{
+    for (const CopyLayout &layout : cLayouts)
+    {
+        if (!CheckCopy(layout, 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool TestSplitCopy()
+{
+    for (const CopyLayout &layout : cLayouts)
+    {
+        if (!CheckCopy(layout, 1))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Row ranges are what each worker copies, so every split point must cover each row exactly once
+static bool TestRowRanges()
+{
+    const CopyLayout layout = { 24, 7, 5, 8, 40, 16, 8 };
+    const SIZE_T srcRowPitch = layout.m_rowSizeInBytes + layout.m_srcRowPadding;
+    const SIZE_T dstRowPitch = layout.m_rowSizeInBytes + layout.m_dstRowPadding;
+    const SIZE_T srcSlicePitch = srcRowPitch * layout.m_numRows + layout.m_srcSlicePadding;
+    const SIZE_T dstSlicePitch = dstRowPitch * layout.m_numRows + layout.m_dstSlicePadding;
+    const UINT64 totalRows = UINT64(layout.m_numRows) * layout.m_numSlices;
+
+    std::vector<BYTE> source(srcSlicePitch * layout.m_numSlices);
+    for (size_t i = 0; i < source.size(); i++)
+    {
+        source[i] = static_cast<BYTE>(i + 1);
+    }
+
+    std::vector<BYTE> whole(dstSlicePitch * layout.m_numSlices, 0);
+    CopyRowsCoalesced(whole.data(), dstRowPitch, dstSlicePitch, source.data(), srcRowPitch, srcSlicePitch,
+        layout.m_rowSizeInBytes, layout.m_numRows, layout.m_numSlices);
+
+    for (UINT64 split = 0; split <= totalRows; split++)
+    {
+        std::vector<BYTE> pieces(whole.size(), 0);
+        CopyRowRange(pieces.data(), dstRowPitch, dstSlicePitch, source.data(), srcRowPitch, srcSlicePitch,
+            layout.m_rowSizeInBytes, layout.m_numRows, 0, split);
+        CopyRowRange(pieces.data(), dstRowPitch, dstSlicePitch, source.data(), srcRowPitch, srcSlicePitch,
+            layout.m_rowSizeInBytes, layout.m_numRows, split, totalRows);
+        TEST_CHECK(pieces == whole);
+    }
+    return true;
+}
+
+int main()
+{
+    static const TestCase cTests[] =
+    {
+        { "CoalescedCopy", TestCoalescedCopy },
+        { "SplitCopy", TestSplitCopy },
+        { "RowRanges", TestRowRanges },
+    };
+    return RunTests(cTests);
+}
@@ -0,0 +1,201 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#pragma once
+
+// The tests only cover headers that don't depend on D3D beyond a few D3D9 enums, so instead of pch.h they get the
+// Windows types, annotations and enums those headers use from here, which lets them build and run on any host.
+#include <cstdint>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <bitset>
+#include <list>
+#include <unordered_map>
+#include <random>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <intrin.h>
+#include <d3d9types.h>
+#else
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
+typedef uint8_t BYTE;
+typedef size_t SIZE_T;
+typedef int64_t INT64;
+typedef unsigned int UINT;
+typedef int INT;
+typedef int BOOL;
+typedef float FLOAT;
+#define FALSE 0
+#define TRUE 1
+#define C_ASSERT(e) static_assert(e, #e)
+
+enum D3DTEXTUREFILTERTYPE
+{
+    D3DTEXF_NONE = 0,
+    D3DTEXF_POINT = 1,
+    D3DTEXF_LINEAR = 2,
+    D3DTEXF_ANISOTROPIC = 3,
+    D3DTEXF_PYRAMIDALQUAD = 6,
+    D3DTEXF_GAUSSIANQUAD = 7,
+};
+
+enum D3DTEXTUREADDRESS
+{
+    D3DTADDRESS_WRAP = 1,
+    D3DTADDRESS_MIRROR = 2,
+    D3DTADDRESS_CLAMP = 3,
+    D3DTADDRESS_BORDER = 4,
+    D3DTADDRESS_MIRRORONCE = 5,
+};
+
+enum D3DPRIMITIVETYPE
+{
+    D3DPT_POINTLIST = 1,
+    D3DPT_LINELIST = 2,
+    D3DPT_LINESTRIP = 3,
+    D3DPT_TRIANGLELIST = 4,
+    D3DPT_TRIANGLESTRIP = 5,
+    D3DPT_TRIANGLEFAN = 6,
+};
+
+enum D3DRESOURCETYPE
+{
+    D3DRTYPE_SURFACE = 1,
+    D3DRTYPE_VOLUME = 2,
+    D3DRTYPE_TEXTURE = 3,
+    D3DRTYPE_VOLUMETEXTURE = 4,
+    D3DRTYPE_CUBETEXTURE = 5,
+    D3DRTYPE_VERTEXBUFFER = 6,
+    D3DRTYPE_INDEXBUFFER = 7,
+};
+
+typedef int64_t LONGLONG;
+union LARGE_INTEGER
+{
+    LONGLONG QuadPart;
+};
+
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER* pCount)
+{
+    pCount->QuadPart = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    return TRUE;
+}
+
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER* pFrequency)
+{
+    pFrequency->QuadPart = 1000000000;
+    return TRUE;
+}
+
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _In_reads_(size)
+#define _Out_writes_(size)
+#define _Out_writes_bytes_(size)
+
+#if defined(__x86_64__)
+#define _M_AMD64 1
+#elif defined(__i386__)
+#define _M_IX86 1
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+inline unsigned char _BitScanForward(unsigned long* pIndex, unsigned long mask)
+{
+    if (mask == 0)
+    {
+        return 0;
+    }
+    *pIndex = __builtin_ctzl(mask);
+    return 1;
+}
+#endif
+
+#define BIT( x ) ( 1 << (x) )
+
+#ifndef D3DRTYPECOUNT
+#define D3DRTYPECOUNT (D3DRTYPE_INDEXBUFFER + 1)
+#endif
+
+// From the shader converter's tokenized program format header, which DataLogger's shader statistics are indexed by
+enum D3D10_SB_TOKENIZED_PROGRAM_TYPE
+{
+    D3D10_SB_PIXEL_SHADER = 0,
+    D3D10_SB_VERTEX_SHADER = 1,
+    D3D10_SB_GEOMETRY_SHADER = 2,
+};
+
+using std::min;
+using std::max;
+
+#define Check9on12(a) if (!(a)) { printf("%s(%d): Check9on12 failed: %s\n", __FILE__, __LINE__, #a); fflush(stdout); abort(); }
+
+namespace D3D9on12
+{
+    // The binding slot counts from pch.h, with D3D9's 16 pixel samplers, 4 vertex samplers and 4 render targets
+    enum
+    {
+        MAX_RENDER_TARGETS = 4,
+        MAX_PIXEL_SAMPLERS = 16,
+        MAX_SAMPLERS_STAGES = 16 + 1 + 4,
+    };
+
+#if (_M_IX86 || _M_AMD64)
+#ifdef _WIN32
+    static bool CanUseSSE4_2()
+    {
+        int cpu_info[4] = {};
+        __cpuid(cpu_info, 1);
+        return (cpu_info[2] >> 20) & 1;
+    }
+    static const bool g_cUseSSE4_2 = CanUseSSE4_2();
+#else
+    static const bool g_cUseSSE4_2 = __builtin_cpu_supports("sse4.2");
+#endif
+#else
+    static const bool g_cUseSSE4_2 = false;
+#endif
+}
+
+#define TEST_CHECK(condition) \
+    if (!(condition)) \
+    { \
+        printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+        return false; \
+    }
+
+struct TestCase
+{
+    const char* m_name;
+    bool(*m_pfnTest)();
+};
+
+template<size_t numTests>
+int RunTests(const TestCase (&tests)[numTests])
+{
+    int failures = 0;
+    for (const TestCase& test : tests)
+    {
+        const bool passed = test.m_pfnTest();
+        printf("[%s] %s\n", passed ? "PASS" : "FAIL", test.m_name);
+        failures += passed ? 0 : 1;
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,284 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <9on12TriangleFan.h>
+
+using namespace D3D9on12;
+
+// Values written past the end of the output would land on these
+static const UINT cGuardElements = 16;
+static const UINT cGuardValue = 0xABCDABCD;
+
+template<typename IndexType>
+static bool CheckGuard(const std::vector<IndexType>& buffer, UINT primitiveCount)
+{
+    for (UINT i = primitiveCount * 3; i < buffer.size(); i++)
+    {
+        TEST_CHECK(buffer[i] == static_cast<IndexType>(cGuardValue));
+    }
+    return true;
+}
+
+// Every primitive count exercises a different split between the SIMD body and the scalar tail
+template<typename IndexType>
+static bool TestGenerateMatchesScalar(UINT maxPrimitiveCount)
+{
+    for (UINT primitiveCount = 0; primitiveCount <= maxPrimitiveCount; primitiveCount++)
+    {
+        std::vector<IndexType> indices(primitiveCount * 3 + cGuardElements, static_cast<IndexType>(cGuardValue));
+        FillTriangleFanIndexBuffer(indices.data(), primitiveCount);
+
+        for (UINT i = 0; i < primitiveCount; i++)
+        {
+            TEST_CHECK(indices[i * 3 + 0] == static_cast<IndexType>(i + 1));
+            TEST_CHECK(indices[i * 3 + 1] == static_cast<IndexType>(i + 2));
+            TEST_CHECK(indices[i * 3 + 2] == 0);
+        }
+        TEST_CHECK(CheckGuard(indices, primitiveCount));
+    }
+    return true;
+}
+
+template<typename IndexType>
+static bool TestConvertMatchesScalar(UINT maxPrimitiveCount, UINT seed)
+{
+    std::mt19937 random(seed);
+    for (UINT primitiveCount = 0; primitiveCount <= maxPrimitiveCount; primitiveCount++)
+    {
+        std::vector<IndexType> source(primitiveCount + 2);
+        for (IndexType& index : source)
+        {
+            index = static_cast<IndexType>(random());
+        }
+
+        std::vector<IndexType> indices(primitiveCount * 3 + cGuardElements, static_cast<IndexType>(cGuardValue));
+        FillTriangleListFromTriangleFan(indices.data(), source.data(), primitiveCount);
+
+        for (UINT i = 0; i < primitiveCount; i++)
+        {
+            TEST_CHECK(indices[i * 3 + 0] == source[i + 1]);
+            TEST_CHECK(indices[i * 3 + 1] == source[i + 2]);
+            TEST_CHECK(indices[i * 3 + 2] == source[0]);
+        }
+        TEST_CHECK(CheckGuard(indices, primitiveCount));
+    }
+    return true;
+}
+
+static bool TestGenerate16() { return TestGenerateMatchesScalar<UINT16>(1024); }
+static bool TestGenerate32() { return TestGenerateMatchesScalar<UINT32>(1024); }
+static bool TestConvert16() { return TestConvertMatchesScalar<UINT16>(1024, 16); }
+static bool TestConvert32() { return TestConvertMatchesScalar<UINT32>(1024, 32); }
+
+// The largest fan that still fits 16-bit indices, where the SIMD increments have to reach 0xFFFF exactly
+static bool TestGenerate16LargestFan()
+{
+    const UINT primitiveCount = UINT16_MAX - 1;
+    std::vector<UINT16> indices(primitiveCount * 3 + cGuardElements, static_cast<UINT16>(cGuardValue));
+    FillTriangleFanIndexBuffer(indices.data(), primitiveCount);
+
+    for (UINT i = 0; i < primitiveCount; i++)
+    {
+        TEST_CHECK(indices[i * 3 + 0] == i + 1);
+        TEST_CHECK(indices[i * 3 + 1] == i + 2);
+        TEST_CHECK(indices[i * 3 + 2] == 0);
+    }
+    TEST_CHECK(CheckGuard(indices, primitiveCount));
+    return true;
+}
+
+// Index values with the sign bit set must not be mangled by the signed SIMD lanes
+static bool TestConvertHighIndexValues()
+{
+    const UINT primitiveCount = 67;
+    std::vector<UINT16> source16(primitiveCount + 2);
+    std::vector<UINT32> source32(primitiveCount + 2);
+    for (UINT i = 0; i < source16.size(); i++)
+    {
+        source16[i] = static_cast<UINT16>(0xFFFF - i);
+        source32[i] = 0xFFFFFFFF - i;
+    }
+
+    std::vector<UINT16> indices16(primitiveCount * 3);
+    std::vector<UINT32> indices32(primitiveCount * 3);
+    FillTriangleListFromTriangleFan(indices16.data(), source16.data(), primitiveCount);
+    FillTriangleListFromTriangleFan(indices32.data(), source32.data(), primitiveCount);
+
+    for (UINT i = 0; i < primitiveCount; i++)
+    {
+        TEST_CHECK(indices16[i * 3 + 0] == source16[i + 1] && indices16[i * 3 + 1] == source16[i + 2] && indices16[i * 3 + 2] == source16[0]);
+        TEST_CHECK(indices32[i * 3 + 0] == source32[i + 1] && indices32[i * 3 + 1] == source32[i + 2] && indices32[i * 3 + 2] == source32[0]);
+    }
+    return true;
+}
+
+// The converted buffers are stood in for by an ID, one per conversion
+typedef TriangleFanConversionCache<UINT, 4> TestConversionCache;
+
+static bool TestConversionsAreKeyedByRangeAndStride()
+{
+    TestConversionCache cache;
+    cache.Insert(1, 0, 30, 2);
+    TEST_CHECK(cache.Find(0, 30, 2) && *cache.Find(0, 30, 2) == 1);
+
+    // Same start, but a different count or index size reads other data
+    TEST_CHECK(cache.Find(0, 33, 2) == nullptr);
+    TEST_CHECK(cache.Find(0, 30, 4) == nullptr);
+    TEST_CHECK(cache.Find(2, 30, 2) == nullptr);
+    return true;
+}
+
+// Fans drawn from the same index buffer no longer evict each other, only the least recently used one is replaced
+static bool TestConversionsEvictLeastRecentlyUsed()
+{
+    TestConversionCache cache;
+    for (UINT i = 0; i < 4; i++)
+    {
+        cache.Insert(i, i * 100, 30, 2);
+    }
+    for (UINT draw = 0; draw < 10; draw++)
+    {
+        for (UINT i = 0; i < 4; i++)
+        {
+            TEST_CHECK(cache.Find(i * 100, 30, 2) && *cache.Find(i * 100, 30, 2) == i);
+        }
+    }
+
+    // Use the first range again so the second one is the least recently used
+    cache.Find(0, 30, 2);
+    cache.Insert(4, 400, 30, 2);
+    TEST_CHECK(cache.Find(100, 30, 2) == nullptr);
+    TEST_CHECK(cache.Find(0, 30, 2) && cache.Find(200, 30, 2) && cache.Find(300, 30, 2) && cache.Find(400, 30, 2));
+    return true;
+}
+
+// A write only drops the conversions whose N + 2 source indices it overlaps
+static bool TestConversionsInvalidateOverlappingWrites()
+{
+    TestConversionCache cache;
+    // 10 triangles of 16-bit indices read bytes [0, 24) and [100, 124)
+    cache.Insert(1, 0, 30, 2);
+    cache.Insert(2, 100, 30, 2);
+
+    cache.Invalidate(24, 76);
+    TEST_CHECK(cache.Find(0, 30, 2) && cache.Find(100, 30, 2));
+
+    cache.Invalidate(23, 1);
+    TEST_CHECK(cache.Find(0, 30, 2) == nullptr);
+    TEST_CHECK(cache.Find(100, 30, 2) != nullptr);
+
+    // Invalidated entries are reused before any valid one is evicted
+    for (UINT i = 0; i < 3; i++)
+    {
+        cache.Insert(10 + i, 1000 + i * 100, 30, 2);
+    }
+    TEST_CHECK(cache.Find(100, 30, 2) != nullptr);
+
+    cache.Invalidate(0, UINT_MAX);
+    TEST_CHECK(cache.Find(100, 30, 2) == nullptr);
+    TEST_CHECK(cache.Find(1200, 30, 2) == nullptr);
+    return true;
+}
+
+typedef WireframeTriangleFanIndexCache<4, 64> TestWireframeCache;
+
+static bool TestWireframeIndicesFollowEdgeFlags()
+{
+    TestWireframeCache cache;
+
+    // Every edge of a 2 triangle fan: the first outer edge, both inner edges and the last outer edge
+    const std::vector<UINT> allEdges = { 0, 1, 1, 2, 2, 3, 3, 0 };
+    TEST_CHECK(cache.GetIndices(2, 0x1 | 0x2 | (0x2 << 1) | (0x4 << 1)) == allEdges);
+
+    // Only the inner edge of the second triangle
+    const std::vector<UINT> innerEdge = { 2, 3 };
+    TEST_CHECK(cache.GetIndices(2, 0x2 << 1) == innerEdge);
+
+    TEST_CHECK(cache.GetIndices(3, 0).empty());
+    return true;
+}
+
+// The cached draws don't create anything, only the first draw of each pattern generates its indices
+static bool TestWireframeRepeatedDrawsGenerateOnce()
+{
+    TestWireframeCache cache;
+    for (UINT draw = 0; draw < 100; draw++)
+    {
+        cache.GetIndices(10, 0x3FF);
+        cache.GetIndices(20, 0x2AAAA);
+    }
+    TEST_CHECK(cache.GetNumGeneratedPatterns() == 2);
+    TEST_CHECK(cache.GetNumCachedPatterns() == 2);
+    return true;
+}
+
+// Past the cap only the least recently used pattern is evicted, so a hot pattern survives a stream of one-off patterns
+static bool TestWireframeEvictsLeastRecentlyUsed()
+{
+    TestWireframeCache cache;
+    cache.GetIndices(8, 0xFF);
+    for (UINT edgeFlags = 0; edgeFlags < 32; edgeFlags++)
+    {
+        cache.GetIndices(8, 0xFF);
+        cache.GetIndices(16, edgeFlags);
+        TEST_CHECK(cache.GetNumCachedPatterns() <= 4);
+    }
+    // The hot pattern was only generated once, and every one-off pattern exactly once
+    TEST_CHECK(cache.GetNumGeneratedPatterns() == 1 + 32);
+
+    // The 3 most recent one-off patterns are still cached, the one before them was evicted
+    const UINT64 generated = cache.GetNumGeneratedPatterns();
+    cache.GetIndices(16, 31);
+    cache.GetIndices(16, 30);
+    cache.GetIndices(16, 29);
+    TEST_CHECK(cache.GetNumGeneratedPatterns() == generated);
+    cache.GetIndices(16, 28);
+    TEST_CHECK(cache.GetNumGeneratedPatterns() == generated + 1);
+    return true;
+}
+
+// Huge fans are generated every time without evicting anything
+static bool TestWireframeHugeFansArentCached()
+{
+    TestWireframeCache cache;
+    for (UINT i = 0; i < 4; i++)
+    {
+        cache.GetIndices(8, i);
+    }
+
+    const std::vector<UINT> firstEdge = { 0, 1 };
+    TEST_CHECK(cache.GetIndices(65, 0x1) == firstEdge);
+    TEST_CHECK(cache.GetIndices(65, 0x1) == firstEdge);
+    TEST_CHECK(cache.GetNumGeneratedPatterns() == 4 + 2);
+    TEST_CHECK(cache.GetNumCachedPatterns() == 4);
+
+    for (UINT i = 0; i < 4; i++)
+    {
+        cache.GetIndices(8, i);
+    }
+    TEST_CHECK(cache.GetNumGeneratedPatterns() == 4 + 2);
+    return true;
+}
+
+int main()
+{
+    printf("SSE4.2 %s\n", g_cUseSSE4_2 ? "available" : "unavailable, 16-bit conversions use the scalar path");
+
+    static const TestCase cTests[] =
+    {
+        { "Generate16", TestGenerate16 },
+        { "Generate32", TestGenerate32 },
+        { "Generate16LargestFan", TestGenerate16LargestFan },
+        { "Convert16", TestConvert16 },
+        { "Convert32", TestConvert32 },
+        { "ConvertHighIndexValues", TestConvertHighIndexValues },
+        { "ConversionsAreKeyedByRangeAndStride", TestConversionsAreKeyedByRangeAndStride },
+        { "ConversionsEvictLeastRecentlyUsed", TestConversionsEvictLeastRecentlyUsed },
+        { "ConversionsInvalidateOverlappingWrites", TestConversionsInvalidateOverlappingWrites },
+        { "WireframeIndicesFollowEdgeFlags", TestWireframeIndicesFollowEdgeFlags },
+        { "WireframeRepeatedDrawsGenerateOnce", TestWireframeRepeatedDrawsGenerateOnce },
+        { "WireframeEvictsLeastRecentlyUsed", TestWireframeEvictsLeastRecentlyUsed },
+        { "WireframeHugeFansArentCached", TestWireframeHugeFansArentCached },
+    };
+    return RunTests(cTests);
+}
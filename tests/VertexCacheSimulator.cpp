@@ -0,0 +1,167 @@
+﻿// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+#include "TestPlatform.h"
+#include <deque>
+#include <9on12VertexCache.h>
+
+using namespace D3D9on12;
+
+// Offline model of the post-transform vertex cache sizes reported through D3DQUERYTYPE_VCACHE. Prints the average cache
+// miss ratio (vertex shader invocations per triangle) of a few index orderings under each reported size, and checks the
+// model against cases with a known answer.
+enum class VertexCacheReplacementPolicy
+{
+    FIFO,
+    LRU,
+};
+
+static double SimulatePostTransformVertexCacheACMR(const std::vector<UINT>& indices, UINT cacheSize, VertexCacheReplacementPolicy policy)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return 0.0;
+    }
+
+    // Most recently inserted (FIFO) or used (LRU) entry at the front
+    std::deque<UINT> cache;
+    size_t missCount = 0;
+    for (size_t i = 0; i < triangleCount * 3; i++)
+    {
+        const UINT index = indices[i];
+        auto entry = std::find(cache.begin(), cache.end(), index);
+        if (entry != cache.end())
+        {
+            if (policy == VertexCacheReplacementPolicy::LRU)
+            {
+                cache.erase(entry);
+                cache.push_front(index);
+            }
+            continue;
+        }
+
+        missCount++;
+        if (cacheSize > 0)
+        {
+            if (cache.size() == cacheSize)
+            {
+                cache.pop_back();
+            }
+            cache.push_front(index);
+        }
+    }
+
+    return double(missCount) / double(triangleCount);
+}
+
+// Two triangles per quad of a gridSize x gridSize quad grid, visiting the quads in vertical bands of bandWidth columns.
+// A band as wide as the grid is the usual row by row order.
+static std::vector<UINT> GridIndices(UINT gridSize, UINT bandWidth)
+{
+    std::vector<UINT> indices;
+    const UINT stride = gridSize + 1;
+    for (UINT bandStart = 0; bandStart < gridSize; bandStart += bandWidth)
+    {
+        for (UINT y = 0; y < gridSize; y++)
+        {
+            for (UINT x = bandStart; x < min(bandStart + bandWidth, gridSize); x++)
+            {
+                const UINT v = y * stride + x;
+                indices.insert(indices.end(), { v, v + stride, v + 1, v + 1, v + stride, v + stride + 1 });
+            }
+        }
+    }
+    return indices;
+}
+
+static std::vector<UINT> ShuffledTriangles(std::vector<UINT> indices)
+{
+    std::mt19937 random(48);
+    for (size_t i = indices.size() / 3; i > 1; i--)
+    {
+        const size_t j = random() % i;
+        std::swap_ranges(indices.begin() + (i - 1) * 3, indices.begin() + i * 3, indices.begin() + j * 3);
+    }
+    return indices;
+}
+
+static std::vector<UINT> DisjointTriangles(UINT triangleCount)
+{
+    std::vector<UINT> indices(triangleCount * 3);
+    for (UINT i = 0; i < indices.size(); i++)
+    {
+        indices[i] = i;
+    }
+    return indices;
+}
+
+static bool TestKnownResults()
+{
+    const VertexCacheReplacementPolicy cPolicies[] = { VertexCacheReplacementPolicy::FIFO, VertexCacheReplacementPolicy::LRU };
+    for (VertexCacheReplacementPolicy policy : cPolicies)
+    {
+        // Nothing to reuse, or nowhere to keep it
+        TEST_CHECK(SimulatePostTransformVertexCacheACMR(DisjointTriangles(100), 24, policy) == 3.0);
+        TEST_CHECK(SimulatePostTransformVertexCacheACMR(GridIndices(8, 8), 0, policy) == 3.0);
+        TEST_CHECK(SimulatePostTransformVertexCacheACMR({}, 16, policy) == 0.0);
+
+        // A cache holding the whole mesh shades every vertex exactly once
+        TEST_CHECK(SimulatePostTransformVertexCacheACMR(GridIndices(8, 8), 1024, policy) == 81.0 / 128.0);
+    }
+
+    // Bands narrower than the cache reuse the shared row between quads, so they can't do worse than rows wider than it
+    for (UINT cacheSize : { 14u, 16u, 24u })
+    {
+        TEST_CHECK(SimulatePostTransformVertexCacheACMR(GridIndices(64, 4), cacheSize, VertexCacheReplacementPolicy::FIFO) <
+            SimulatePostTransformVertexCacheACMR(GridIndices(64, 64), cacheSize, VertexCacheReplacementPolicy::FIFO));
+    }
+    return true;
+}
+
+static void PrintACMRTable()
+{
+    struct Stream
+    {
+        const char* m_name;
+        std::vector<UINT> m_indices;
+    };
+    const Stream cStreams[] =
+    {
+        { "64x64 grid, rows", GridIndices(64, 64) },
+        { "64x64 grid, 8 column bands", GridIndices(64, 8) },
+        { "64x64 grid, 4 column bands", GridIndices(64, 4) },
+        { "64x64 grid, shuffled", ShuffledTriangles(GridIndices(64, 64)) },
+    };
+    const UINT cVendorIDs[] = { 0x10DE, 0x8086, 0x1002, 0 };
+
+    printf("%-28s", "ACMR (FIFO / LRU)");
+    for (UINT vendorID : cVendorIDs)
+    {
+        printf("   size %2u (0x%04X)", GetDefaultPostTransformVertexCacheSize(vendorID), vendorID);
+    }
+    printf("\n");
+
+    for (const Stream& stream : cStreams)
+    {
+        printf("%-28s", stream.m_name);
+        for (UINT vendorID : cVendorIDs)
+        {
+            const UINT cacheSize = GetDefaultPostTransformVertexCacheSize(vendorID);
+            printf("   %6.3f / %6.3f  ",
+                SimulatePostTransformVertexCacheACMR(stream.m_indices, cacheSize, VertexCacheReplacementPolicy::FIFO),
+                SimulatePostTransformVertexCacheACMR(stream.m_indices, cacheSize, VertexCacheReplacementPolicy::LRU));
+        }
+        printf("\n");
+    }
+}
+
+int main()
+{
+    PrintACMRTable();
+
+    static const TestCase cTests[] =
+    {
+        { "KnownResults", TestKnownResults },
+    };
+    return RunTests(cTests);
+}